@@ -0,0 +1,107 @@
+#include "one-wire-adapter.h"
+#include <stddef.h>
+
+#if !defined(W1_BACKEND_EXTERN) || !defined(W1_BACKEND_THREADS)
+  #error Adapters need W1_BACKEND_EXTERN and W1_BACKEND_THREADS
+#endif
+
+// Values of the claim of an adapter
+#define W1_ADAPTER_IDLE              0
+#define W1_ADAPTER_SCHEDULED         1
+#define W1_ADAPTER_RUNNING           2
+
+/**
+ * Sets up an adapter
+ * @param  adapter  The adapter
+ * @param  backend  Backend specific data for the bus, see wire1context_t
+ */
+void wire1AdapterInit(wire1adapter_t *const adapter, void *const backend) {
+  adapter->context.state = IDLE;
+  adapter->context.idleloops = 0;
+  adapter->context.backend = backend;
+  adapter->pending = NULL;
+  adapter->claim = W1_ADAPTER_IDLE;
+}
+
+/**
+ * Submits a job to the executor of an adapter. Lock free, and can be called
+ * from any thread.
+ * @param  adapter  The adapter
+ * @param  job      The job (must be kept until it has run)
+ * @return          1 if the adapter went from idle to scheduled, and
+ *                  wire1AdapterRun shall be scheduled on an executor for it;
+ *                  otherwise 0 (it is already scheduled or running)
+ */
+uint8_t wire1AdapterSubmit(wire1adapter_t *const adapter, wire1job_t *const job) {
+  wire1job_t *head = __atomic_load_n(&adapter->pending, __ATOMIC_RELAXED);
+  do {
+    job->next = head;
+  } while (!__atomic_compare_exchange_n(&adapter->pending, &head, job, 1,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+
+  uint8_t idle = W1_ADAPTER_IDLE;
+  return __atomic_compare_exchange_n(&adapter->claim, &idle,
+                                     W1_ADAPTER_SCHEDULED, 0,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+/**
+ * Claims an adapter for running its jobs
+ * @param  adapter  The adapter
+ * @return          1 if claimed; 0 if another thread is running it
+ */
+static uint8_t wire1AdapterClaim(wire1adapter_t *const adapter) {
+  uint8_t claim = __atomic_load_n(&adapter->claim, __ATOMIC_RELAXED);
+  do {
+    if (claim == W1_ADAPTER_RUNNING)
+      return 0;
+  } while (!__atomic_compare_exchange_n(&adapter->claim, &claim,
+                                        W1_ADAPTER_RUNNING, 1,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+  return 1;
+}
+
+/**
+ * Runs the jobs that have been submitted to an adapter, in the order they were
+ * submitted, until there are none left. Shall be called by the executor of
+ * the adapter, typically when wire1AdapterSubmit has returned 1. The adapter
+ * is claimed meanwhile, and nothing is run if another thread already runs it.
+ * @param  adapter  The adapter
+ * @return          Number of jobs that were run
+ */
+uint32_t wire1AdapterRun(wire1adapter_t *const adapter) {
+  if (!wire1AdapterClaim(adapter))
+    return 0;
+
+  wire1context_t *previous = wire1GetContext();
+  wire1SetContext(&adapter->context);
+  uint32_t count = 0;
+  do {
+    wire1job_t *job = __atomic_exchange_n(&adapter->pending, NULL, __ATOMIC_ACQUIRE);
+    while (job) {
+      // Reverse the list to get the jobs in submission order
+      wire1job_t *ordered = NULL;
+      while (job) {
+        wire1job_t *next = job->next;
+        job->next = ordered;
+        ordered = job;
+        job = next;
+      }
+      while (ordered) {
+        // The job may be freed when it has run
+        wire1job_t *next = ordered->next;
+        ordered->run(ordered);
+        ordered = next;
+        count++;
+      }
+      job = __atomic_exchange_n(&adapter->pending, NULL, __ATOMIC_ACQUIRE);
+    }
+
+    // Release the claim, and take it back if a job was submitted meanwhile
+    // (its submitter saw the adapter running and did not schedule it)
+    __atomic_store_n(&adapter->claim, W1_ADAPTER_IDLE, __ATOMIC_SEQ_CST);
+  } while (__atomic_load_n(&adapter->pending, __ATOMIC_SEQ_CST) &&
+           wire1AdapterClaim(adapter));
+  wire1SetContext(previous);
+  return count;
+}
@@ -0,0 +1,45 @@
+#ifndef ONE_WIRE_ADAPTER_H
+#define ONE_WIRE_ADAPTER_H
+
+#include <stdint.h>
+#include "one-wire.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Adapters for host builds (W1_BACKEND_EXTERN and W1_BACKEND_THREADS) that
+// drive many buses from many threads. Each adapter holds all the state of its
+// bus, and is served by one executor thread at a time that runs the jobs
+// submitted to it. Jobs can be submitted from any thread without locks.
+// An adapter is claimed by the executor while it runs jobs, so that it is
+// never driven by two threads at once, and a submission tells when the
+// adapter has gone from idle to scheduled and needs an executor.
+
+/** A job to run on the executor of an adapter, embedded in the caller's data */
+typedef struct wire1job_s {
+  /** Called on the executor, with the context of the adapter selected */
+  void (*run)(struct wire1job_s *const job);
+  /** Used by the submission queue */
+  struct wire1job_s *next;
+} wire1job_t;
+
+/** One bus adapter */
+typedef struct {
+  /** The state of the bus, including the backend data */
+  wire1context_t context;
+  /** Submitted jobs, newest first (only accessed atomically) */
+  wire1job_t *pending;
+  /** Idle, scheduled or running (only accessed atomically) */
+  uint8_t claim;
+} wire1adapter_t;
+
+void     wire1AdapterInit(wire1adapter_t *const adapter, void *const backend);
+uint8_t  wire1AdapterSubmit(wire1adapter_t *const adapter, wire1job_t *const job);
+uint32_t wire1AdapterRun(wire1adapter_t *const adapter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
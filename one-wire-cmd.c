@@ -0,0 +1,155 @@
+#include "one-wire.h"
+#include "one-wire-cmd.h"
+
+/**
+ * Finishes a response frame by appending its CRC
+ * @param  response  The response frame
+ * @param  size      Size of the response so far
+ * @return           Size of the finished response
+ */
+static uint8_t wire1CmdFinish(uint8_t *const response, uint8_t const size) {
+  response[size] = crc8(0, W1_CRC_POLYNOMIAL, response, size);
+  return size + 1;
+}
+
+/**
+ * Finishes a response frame with an error status
+ * @param  response  The response frame
+ * @param  status    The error status
+ * @param  index     Index of the failing operation
+ * @return           Size of the finished response
+ */
+static uint8_t wire1CmdError(
+  uint8_t *const response,
+  uint8_t const status,
+  uint8_t const index
+) {
+  response[0] = status;
+  response[1] = index;
+  return wire1CmdFinish(response, 2);
+}
+
+#ifndef W1_BACKEND_EXTERN
+/**
+ * Keeps the strong pull-up for a time, and then releases the wire
+ * @param  ms  The time in ms
+ */
+static void wire1CmdHoldPullUp(uint16_t ms) {
+  while (ms--) {
+    // The wire is driven high, so this times out after 1 ms
+    wire1Poll4Hold(247); // 1002 us = 4*247 + 14
+  }
+  wire1Release();
+}
+#endif
+
+/**
+ * Executes a request frame of batched bus operations back-to-back and builds
+ * the response frame, see one-wire-cmd.h for the format.
+ *
+ * @param  request      The request frame, including the trailing CRC
+ * @param  requestSize  Size of the request frame
+ * @param  response     Where to build the response frame
+ * @param  responseMax  Size of the response buffer (at least 3 byte)
+ * @return              Size of the response frame
+ */
+uint8_t wire1CmdExecute(
+  uint8_t *const request,
+  uint8_t const requestSize,
+  uint8_t *const response,
+  uint8_t const responseMax
+) {
+  if (!requestSize || crc8(0, W1_CRC_POLYNOMIAL, request, requestSize)) {
+    return wire1CmdError(response, W1_CMD_ERR_CRC, 0);
+  }
+
+  uint8_t end = requestSize - 1; // Skip the CRC
+  uint8_t in = 0;
+  uint8_t out = 1; // Leave room for the status
+  // Leave room for the response CRC
+  uint8_t outMax = responseMax - 1;
+
+  for (uint8_t index = 0; in < end; index++) {
+    uint8_t operation = request[in++];
+    uint8_t n;
+
+    switch (operation) {
+    case W1_CMD_RESET:
+      if (out + 1 > outMax)
+        return wire1CmdError(response, W1_CMD_ERR_OVERFLOW, index);
+      response[out++] = wire1Reset();
+      break;
+
+    case W1_CMD_WRITE:
+      if (in + 1 > end || in + 1 + request[in] > end)
+        return wire1CmdError(response, W1_CMD_ERR_TRUNCATED, index);
+      n = request[in++];
+      for (int i = 0; i < n; i++) {
+        wire1WriteByte(request[in++]);
+      }
+      break;
+
+    case W1_CMD_READ:
+      if (in + 1 > end)
+        return wire1CmdError(response, W1_CMD_ERR_TRUNCATED, index);
+      n = request[in++];
+      if (out + n > outMax)
+        return wire1CmdError(response, W1_CMD_ERR_OVERFLOW, index);
+      for (int i = 0; i < n; i++) {
+        response[out++] = wire1ReadByte();
+      }
+      break;
+
+    case W1_CMD_SEARCH:
+      if (in + 10 > end)
+        return wire1CmdError(response, W1_CMD_ERR_TRUNCATED, index);
+      if (out + 9 > outMax)
+        return wire1CmdError(response, W1_CMD_ERR_OVERFLOW, index);
+      {
+        uint8_t command = request[in];
+        uint8_t lastConfPos = request[in + 1];
+        uint8_t *addr = &response[out + 1];
+        for (int i = 0; i < 8; i++) {
+          addr[i] = request[in + 2 + i];
+        }
+        in += 10;
+        if (command == W1_ROMCMD_ALARM) {
+          response[out] = wire1AlarmSearchLargerROM(addr, addr, lastConfPos);
+        } else {
+          response[out] = wire1SearchLargerROM(addr, addr, lastConfPos);
+        }
+        out += 9;
+      }
+      break;
+
+    case W1_CMD_STRONG_PULLUP:
+    case W1_CMD_WRITE_PULLUP:
+      {
+        uint8_t size = (operation == W1_CMD_WRITE_PULLUP) ? 3 : 2;
+        if (in + size > end)
+          return wire1CmdError(response, W1_CMD_ERR_TRUNCATED, index);
+#ifndef W1_BACKEND_EXTERN
+        if (operation == W1_CMD_WRITE_PULLUP) {
+          // Drive the wire high straight out of the last slot
+          wire1WriteBytePullUp(request[in++]);
+        } else {
+          wire1StrongPullUp();
+        }
+        uint16_t ms = request[in] | (request[in + 1] << 8);
+        in += 2;
+        wire1CmdHoldPullUp(ms);
+        break;
+#else
+        // The backends have no strong pull-up
+        return wire1CmdError(response, W1_CMD_ERR_OPERATION, index);
+#endif
+      }
+
+    default:
+      return wire1CmdError(response, W1_CMD_ERR_OPERATION, index);
+    }
+  }
+
+  response[0] = W1_CMD_OK;
+  return wire1CmdFinish(response, out);
+}
@@ -0,0 +1,60 @@
+#ifndef ONE_WIRE_CMD_H
+#define ONE_WIRE_CMD_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Batched raw bus operations for a host on the other side of a serial link.
+//
+// A request frame is a list of operations followed by the crc8 of the list,
+// and is answered with one response frame: a status byte, the results of the
+// operations in order, and the crc8 of the status and results. The serial
+// transport (e.g. a length byte in front of each frame) is up to the
+// application.
+//
+// Operation              Arguments                    Result
+// W1_CMD_RESET           -                            presence (int8)
+// W1_CMD_WRITE           n, n bytes                   -
+// W1_CMD_READ            n                            n bytes
+// W1_CMD_SEARCH          command, lastConfPos, ROM    conflict pos (int8), ROM
+// W1_CMD_STRONG_PULLUP   time in ms (uint16)          -
+// W1_CMD_WRITE_PULLUP    byte, time in ms (uint16)    -
+//
+// Multi-byte arguments are little endian. W1_CMD_WRITE_PULLUP writes one byte
+// (e.g. Convert T) and drives the wire high straight out of its last slot, as
+// parasite powered slaves need within 10 us; a separate W1_CMD_STRONG_PULLUP
+// after a W1_CMD_WRITE comes too late for that.
+// The strong pull-up is only supported by the AVR implementation, and both
+// operations fail with W1_CMD_ERR_OPERATION when built with W1_BACKEND_EXTERN.
+
+// Operations
+#define W1_CMD_RESET                 0x01
+#define W1_CMD_WRITE                 0x02
+#define W1_CMD_READ                  0x03
+#define W1_CMD_SEARCH                0x04
+#define W1_CMD_STRONG_PULLUP         0x05
+#define W1_CMD_WRITE_PULLUP          0x06
+
+// Status byte of the response. An error status is followed by the index of
+// the failing operation instead of any results.
+#define W1_CMD_OK                    0x00
+#define W1_CMD_ERR_CRC               0x01
+#define W1_CMD_ERR_OPERATION         0x02
+#define W1_CMD_ERR_TRUNCATED         0x03
+#define W1_CMD_ERR_OVERFLOW          0x04
+
+uint8_t wire1CmdExecute(
+  uint8_t *const request,
+  uint8_t const requestSize,
+  uint8_t *const response,
+  uint8_t const responseMax
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,123 @@
+#include "one-wire.h"
+#include "one-wire-ds2408.h"
+
+/**
+ * Addresses one DS2408, or all devices
+ * @param  addr  Pointer to the ROM address of the device; NULL to skip ROM
+ * @return       0 - OK; -1 - no device present
+ */
+static int8_t wire1DS2408Address(uint8_t *const addr) {
+  return addr ? wire1MatchROM(addr) : wire1SkipROM();
+}
+
+/**
+ * Reads the PIO registers from the state register up to the activity latches
+ * of the device that is already addressed
+ * @param  state     The logic state of the PIO pins
+ * @param  activity  The activity latches
+ */
+static void wire1DS2408ReadRegisters(uint8_t *const state, uint8_t *const activity) {
+  wire1WriteByte(W1_DS2408_READ_PIO);
+  wire1WriteByte(W1_DS2408_REG_PIO_STATE);
+  wire1WriteByte(0);
+  *state = wire1ReadByte();
+  wire1ReadByte(); // Output latch state
+  *activity = wire1ReadByte();
+}
+
+/**
+ * Sets up the conditional search of a DS2408, so that it takes part in alarm
+ * searches when any of the selected pins has new activity. Also clears the
+ * power-on reset latch, which otherwise makes the device always take part.
+ * The whole control/status register is written, so the configuration of the
+ * RSTZ pin is given as well.
+ * @param  addr    Pointer to the ROM address of the device; NULL for all
+ *                 devices
+ * @param  mask    The pins to watch (bit set for each pin)
+ * @param  strobe  [boolean] Whether the RSTZ pin is a strobe output (ROS),
+ *                 otherwise a reset input
+ * @return         0 - OK; -1 - no device present
+ */
+int8_t wire1DS2408SetupEvents(
+  uint8_t *const addr,
+  uint8_t const mask,
+  uint8_t const strobe
+) {
+  if (wire1DS2408Address(addr))
+    return -1;
+  wire1WriteByte(W1_DS2408_WRITE_COND_SEARCH);
+  wire1WriteByte(W1_DS2408_REG_COND_MASK);
+  wire1WriteByte(0);
+  wire1WriteByte(mask); // Channel selection mask
+  wire1WriteByte(mask); // Polarity: a set activity latch is the condition
+  // Latches, OR, clears PORL
+  wire1WriteByte(BV(W1_DS2408_CTRL_PLS_BIT) |
+                 (strobe ? BV(W1_DS2408_CTRL_ROS_BIT) : 0));
+  return 0;
+}
+
+/**
+ * Reads the PIO state and activity latches of a DS2408
+ * @param  addr      Pointer to the ROM address of the device
+ * @param  state     The logic state of the PIO pins
+ * @param  activity  The activity latches (bit set for each changed pin)
+ * @return           0 - OK; -1 - no device present
+ */
+int8_t wire1DS2408ReadActivity(
+  uint8_t *const addr,
+  uint8_t *const state,
+  uint8_t *const activity
+) {
+  if (wire1DS2408Address(addr))
+    return -1;
+  wire1DS2408ReadRegisters(state, activity);
+  return 0;
+}
+
+/**
+ * Resets the activity latches of a DS2408
+ * @param  addr  Pointer to the ROM address of the device; NULL for all devices
+ * @return       0 - OK; 1 - no confirmation from the device; -1 - no device
+ *               present
+ */
+int8_t wire1DS2408ResetActivity(uint8_t *const addr) {
+  if (wire1DS2408Address(addr))
+    return -1;
+  wire1WriteByte(W1_DS2408_RESET_ACTIVITY);
+  return wire1ReadByte() == W1_DS2408_RESET_CONFIRM ? 0 : 1;
+}
+
+/**
+ * Finds the DS2408s with new input activity with alarm searches, and reads
+ * and resets the activity latches of only those. The devices shall have been
+ * set up with wire1DS2408SetupEvents. When nothing has changed, this is a
+ * single alarm search that nothing answers.
+ * @param  event  Called for every device with new activity
+ * @return        Number of devices with new activity
+ */
+int16_t wire1DS2408PollEvents(wire1DS2408Event_t const event) {
+  uint8_t addr[8] = {0};
+  uint8_t lastConfPos = 0xFF;
+  int16_t count = 0;
+
+  for (;;) {
+    int8_t result = wire1AlarmSearchLargerROM(addr, addr, lastConfPos);
+    if (result < 0)
+      break;
+
+    // Other kinds of devices may have alarms too
+    if (addr[W1_ADDR_BYTE_DEV_TYPE] == DS2408) {
+      uint8_t state, activity;
+      // The found device is still selected after the search
+      wire1DS2408ReadRegisters(&state, &activity);
+      wire1DS2408ResetActivity(addr);
+      event(addr, state, activity);
+      count++;
+    }
+
+    if (result == 64)
+      break;
+    lastConfPos = result;
+  }
+  return count;
+}
@@ -0,0 +1,57 @@
+#ifndef ONE_WIRE_DS2408_H
+#define ONE_WIRE_DS2408_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// DS2408 function commands
+#define W1_DS2408_READ_PIO           0xF0
+#define W1_DS2408_WRITE_COND_SEARCH  0xCC
+#define W1_DS2408_RESET_ACTIVITY     0xC3
+
+// DS2408 register addresses (the high byte is always 0)
+#define W1_DS2408_REG_PIO_STATE      0x88
+#define W1_DS2408_REG_ACTIVITY       0x8A
+#define W1_DS2408_REG_COND_MASK      0x8B
+
+// Bits in the control/status register
+#define W1_DS2408_CTRL_PLS_BIT       0 // Condition on activity latches
+#define W1_DS2408_CTRL_CT_BIT        1 // AND (not OR) of the channels
+#define W1_DS2408_CTRL_ROS_BIT       2 // RSTZ pin is a strobe output
+
+// Answer to the reset activity latches command
+#define W1_DS2408_RESET_CONFIRM      0xAA
+
+/**
+ * Called for every DS2408 with new input activity
+ * @param  addr      The ROM address of the device
+ * @param  state     The logic state of the PIO pins
+ * @param  activity  The activity latches (bit set for each changed pin)
+ */
+typedef void (*wire1DS2408Event_t)(
+  uint8_t *const addr,
+  uint8_t const state,
+  uint8_t const activity
+);
+
+int8_t  wire1DS2408SetupEvents(
+  uint8_t *const addr,
+  uint8_t const mask,
+  uint8_t const strobe
+);
+int8_t  wire1DS2408ReadActivity(
+  uint8_t *const addr,
+  uint8_t *const state,
+  uint8_t *const activity
+);
+int8_t  wire1DS2408ResetActivity(uint8_t *const addr);
+int16_t wire1DS2408PollEvents(wire1DS2408Event_t const event);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
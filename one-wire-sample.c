@@ -0,0 +1,277 @@
+#include "one-wire-sample.h"
+
+/**
+ * Clears the statistics, e.g. after the summary for an interval has been sent
+ * @param  stats  The statistics to clear
+ */
+void wire1StatsReset(wire1stats_t *const stats) {
+  stats->count = 0;
+  stats->min   = INT16_MAX;
+  stats->max   = INT16_MIN;
+  stats->mean  = 0;
+  stats->m2    = 0;
+}
+
+/**
+ * Adds one reading to the statistics with Welford's algorithm, in constant
+ * time and without storing the readings.
+ * The fixed point products fit in 32 bits as long as a reading differs less
+ * than 2896 from the mean, which covers the whole range of a 12-bit
+ * temperature sensor (-55 to 125 degrees in steps of 1/16).
+ *
+ * @param  stats   The statistics to update
+ * @param  sample  The raw reading
+ */
+void wire1StatsUpdate(wire1stats_t *const stats, int16_t const sample) {
+  int32_t x = (int32_t)sample << W1_STATS_MEAN_FRAC;
+
+  if (sample < stats->min)
+    stats->min = sample;
+  if (sample > stats->max)
+    stats->max = sample;
+  if (stats->count < UINT16_MAX)
+    stats->count++;
+
+  // The mean never moves past the new reading, so both differences have the
+  // same sign and the product is never negative
+  int32_t delta = x - stats->mean;
+  stats->mean += delta / stats->count;
+  int32_t delta2 = x - stats->mean;
+  // Kept with the fraction bits of both differences, so nothing is truncated
+  uint32_t m2Add = (uint32_t)(delta * delta2);
+
+  // Saturate instead of wrapping around
+  if (stats->m2 > UINT32_MAX - m2Add) {
+    stats->m2 = UINT32_MAX;
+  } else {
+    stats->m2 += m2Add;
+  }
+}
+
+/**
+ * Calculates the sample variance of the readings
+ * @param  stats  The statistics to calculate from
+ * @return        The variance in raw units squared, rounded to nearest; 0 if
+ *                less than 2 readings
+ */
+uint32_t wire1StatsVariance(const wire1stats_t *const stats) {
+  if (stats->count < 2)
+    return 0;
+  uint32_t variance = stats->m2 / (stats->count - 1);
+  return (variance + (1UL << (2 * W1_STATS_MEAN_FRAC - 1))) >> (2 * W1_STATS_MEAN_FRAC);
+}
+
+/**
+ * Clears the deadband filter, so that the next reading is always reported
+ * @param  deadband  The filter to clear
+ */
+void wire1DeadbandReset(wire1deadband_t *const deadband) {
+  deadband->last        = 0;
+  deadband->sinceReport = UINT8_MAX;
+}
+
+/**
+ * Compares a new reading against the last reported one and decides if it
+ * shall be reported.
+ *
+ * @param  deadband   The filter of the device that the reading belongs to
+ * @param  sample     The raw reading
+ * @param  threshold  The reading is reported if it differs more than this
+ *                    from the last reported reading
+ * @param  keepalive  The reading is reported anyway if this many readings in a
+ *                    row have been suppressed (0 reports every reading)
+ * @return            1 if the reading shall be reported; otherwise 0
+ */
+uint8_t wire1DeadbandUpdate(
+  wire1deadband_t *const deadband,
+  int16_t const sample,
+  uint16_t const threshold,
+  uint8_t const keepalive
+) {
+  int32_t diff = (int32_t)sample - deadband->last;
+  if (diff < 0)
+    diff = -diff;
+
+  if (diff > threshold || deadband->sinceReport >= keepalive) {
+    deadband->last        = sample;
+    deadband->sinceReport = 0;
+    return 1;
+  }
+
+  if (deadband->sinceReport < UINT8_MAX)
+    deadband->sinceReport++;
+  return 0;
+}
+
+/**
+ * Clears the sampling state of a device, so that it is read on the next tick
+ * @param  rate    The sampling state to clear
+ * @param  period  The number of ticks between readings until the next plan
+ */
+void wire1RateReset(wire1rate_t *const rate, uint8_t const period) {
+  rate->last    = INT16_MIN;
+  rate->rate    = 0;
+  rate->period  = period ? period : 1;
+  rate->due     = 0;
+  rate->elapsed = 0;
+}
+
+/**
+ * Updates the smoothed change rate of a device with a new reading. The change
+ * is spread over the ticks that have passed since the last reading.
+ * @param  rate    The sampling state of the device
+ * @param  sample  The raw reading
+ */
+void wire1RateUpdate(wire1rate_t *const rate, int16_t const sample) {
+  if (rate->last != INT16_MIN) {
+    int32_t change = (int32_t)sample - rate->last;
+    if (change < 0)
+      change = -change;
+    change = (change << W1_RATE_FRAC) / (rate->elapsed ? rate->elapsed : 1);
+    if (change > UINT16_MAX)
+      change = UINT16_MAX;
+
+    // Exponential moving average
+    rate->rate += (change - (int32_t)rate->rate) >> W1_RATE_SMOOTHING_SHIFT;
+  }
+  rate->last = sample;
+  rate->elapsed = 0;
+}
+
+/**
+ * Advances the sampling state of a device by one scheduler tick
+ * @param  rate  The sampling state of the device
+ * @return       1 if the device shall be read in this tick; otherwise 0
+ */
+uint8_t wire1RateTick(wire1rate_t *const rate) {
+  if (rate->elapsed < UINT8_MAX)
+    rate->elapsed++;
+  if (rate->due) {
+    rate->due--;
+    return 0;
+  }
+  rate->due = rate->period - 1;
+  return 1;
+}
+
+/**
+ * Shares a budget of readings per tick between the devices, and sets the
+ * periods accordingly. Every device is first given the longest period, and
+ * what is left of the budget is then shared in proportion to the change
+ * rates. Devices that have not changed keep the longest period. The periods
+ * are kept within the bounds, so the budget is exceeded if it cannot fit every
+ * device at the longest period.
+ *
+ * @param  rates      The sampling states of the devices
+ * @param  count      Number of devices
+ * @param  minPeriod  The shortest allowed period in ticks
+ * @param  maxPeriod  The longest allowed period in ticks
+ * @param  budget     Number of readings per tick to share between the devices
+ */
+void wire1RatePlan(
+  wire1rate_t *const rates,
+  uint8_t const count,
+  uint8_t const minPeriod,
+  uint8_t const maxPeriod,
+  uint8_t const budget
+) {
+  uint8_t longest = maxPeriod ? maxPeriod : 1;
+  uint32_t rateSum = 0;
+  for (int i = 0; i < count; i++) {
+    rateSum += rates[i].rate;
+  }
+
+  // Readings per tick left when all devices are read at the longest period,
+  // times the longest period
+  uint32_t spare = (uint32_t)budget * longest;
+  spare = (spare > count) ? spare - count : 0;
+
+  for (int i = 0; i < count; i++) {
+    // Readings per tick for the device are
+    //   1/longest + spare/longest * rate/rateSum
+    // and the period is the inverse of that, rounded up to stay within budget
+    uint64_t share = (uint64_t)spare * rates[i].rate;
+    uint32_t period = longest;
+    if (share) {
+      uint64_t num = (uint64_t)longest * rateSum;
+      uint64_t den = rateSum + share;
+      period = (num + den - 1) / den;
+    }
+
+    if (period < minPeriod)
+      period = minPeriod;
+    if (period > longest)
+      period = longest;
+    rates[i].period = period;
+    if (rates[i].due >= period)
+      rates[i].due = period - 1;
+  }
+}
+
+/**
+ * Clears a latency histogram
+ * @param  hist  The histogram to clear
+ */
+void wire1HistogramReset(wire1histogram_t *const hist) {
+  for (int i = 0; i < W1_LATENCY_BINS; i++) {
+    hist->bins[i] = 0;
+  }
+}
+
+/**
+ * Adds the latency between two timer values to a histogram. The timer is
+ * allowed to wrap around once between the two values.
+ * @param  hist  The histogram to add to
+ * @param  from  Timer value at the start, e.g. wire1stamp_t.convert
+ * @param  to    Timer value at the end, e.g. wire1stamp_t.read
+ */
+void wire1HistogramAdd(
+  wire1histogram_t *const hist,
+  uint16_t const from,
+  uint16_t const to
+) {
+  uint16_t latency = to - from;
+
+  // The bin is the number of significant bits in the latency
+  uint8_t bin = 0;
+  while (latency && bin < W1_LATENCY_BINS - 1) {
+    latency >>= 1;
+    bin++;
+  }
+
+  if (hist->bins[bin] == UINT16_MAX) {
+    for (int i = 0; i < W1_LATENCY_BINS; i++) {
+      hist->bins[i] >>= 1;
+    }
+  }
+  hist->bins[bin]++;
+}
+
+/**
+ * Finds the latency that a given percentage of the latencies in the histogram
+ * are below
+ * @param  hist     The histogram to look in
+ * @param  percent  The percentile (0-100)
+ * @return          The upper bound of the bin holding the percentile, in timer
+ *                  ticks; 0 if the histogram is empty
+ */
+uint16_t wire1HistogramPercentile(
+  const wire1histogram_t *const hist,
+  uint8_t const percent
+) {
+  uint32_t total = 0;
+  for (int i = 0; i < W1_LATENCY_BINS; i++) {
+    total += hist->bins[i];
+  }
+  if (!total)
+    return 0;
+
+  uint32_t limit = (total * percent + 99) / 100;
+  uint32_t sum = 0;
+  for (int i = 0; i < W1_LATENCY_BINS - 1; i++) {
+    sum += hist->bins[i];
+    if (sum >= limit)
+      return (1UL << i) - 1;
+  }
+  return UINT16_MAX;
+}
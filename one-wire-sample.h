@@ -0,0 +1,130 @@
+#ifndef ONE_WIRE_SAMPLE_H
+#define ONE_WIRE_SAMPLE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of fraction bits in the fixed point running mean
+#define W1_STATS_MEAN_FRAC           4
+
+// Number of fraction bits in the change rate
+#define W1_RATE_FRAC                 4
+// Weight of a new change in the smoothed change rate (1/2^n)
+#define W1_RATE_SMOOTHING_SHIFT      2
+
+// Number of bins in a latency histogram (bin n holds latencies of n bits)
+#define W1_LATENCY_BINS              16
+
+/**
+ * Incremental statistics for the readings of one device. Kept alongside the
+ * device table and updated once per reading, so that one summary per device
+ * can be sent per interval instead of every reading.
+ */
+typedef struct {
+  /** Number of readings since the last reset (saturates) */
+  uint16_t count;
+  /** Smallest and largest raw reading */
+  int16_t min, max;
+  /** Running mean of the raw readings, with W1_STATS_MEAN_FRAC fraction bits */
+  int32_t mean;
+  /**
+   * Running sum of squared differences from the mean (Welford), with
+   * 2*W1_STATS_MEAN_FRAC fraction bits (saturates)
+   */
+  uint32_t m2;
+} wire1stats_t;
+
+/**
+ * Deadband filter for the readings of one device, so that only readings that
+ * changed enough since the last report (or keepalives) are sent on.
+ */
+typedef struct {
+  /** The last reported raw reading */
+  int16_t last;
+  /** Number of suppressed readings since the last report (saturates) */
+  uint8_t sinceReport;
+} wire1deadband_t;
+
+/**
+ * Sampling state of one device for rate-adaptive sweeps. The period is
+ * counted in scheduler ticks, and devices that change quickly are given
+ * shorter periods than quiet ones by wire1RatePlan.
+ */
+typedef struct {
+  /** The last raw reading (INT16_MIN if there is none yet) */
+  int16_t last;
+  /** Smoothed absolute change per tick, with W1_RATE_FRAC fraction bits */
+  uint16_t rate;
+  /** Number of ticks between readings */
+  uint8_t period;
+  /** Number of ticks left until the next reading */
+  uint8_t due;
+  /** Number of ticks since the last reading (saturates) */
+  uint8_t elapsed;
+} wire1rate_t;
+
+/**
+ * Timer values for one reading, taken by the application from a free running
+ * hardware timer right after wire1ConvertT and wire1ReadScratchPad return
+ */
+typedef struct {
+  /** Timer value when the conversion was started */
+  uint16_t convert;
+  /** Timer value when the scratchpad had been read */
+  uint16_t read;
+} wire1stamp_t;
+
+/**
+ * Rolling histogram of latencies in timer ticks, with logarithmic bins. All
+ * bins are halved when one of them is full, so old latencies fade out.
+ */
+typedef struct {
+  uint16_t bins[W1_LATENCY_BINS];
+} wire1histogram_t;
+
+// Incremental statistics
+void     wire1StatsReset(wire1stats_t *const stats);
+void     wire1StatsUpdate(wire1stats_t *const stats, int16_t const sample);
+uint32_t wire1StatsVariance(const wire1stats_t *const stats);
+
+// Change-only reporting
+void    wire1DeadbandReset(wire1deadband_t *const deadband);
+uint8_t wire1DeadbandUpdate(
+  wire1deadband_t *const deadband,
+  int16_t const sample,
+  uint16_t const threshold,
+  uint8_t const keepalive
+);
+
+// Rate-adaptive sampling
+void    wire1RateReset(wire1rate_t *const rate, uint8_t const period);
+void    wire1RateUpdate(wire1rate_t *const rate, int16_t const sample);
+uint8_t wire1RateTick(wire1rate_t *const rate);
+void    wire1RatePlan(
+  wire1rate_t *const rates,
+  uint8_t const count,
+  uint8_t const minPeriod,
+  uint8_t const maxPeriod,
+  uint8_t const budget
+);
+
+// Latency histograms
+void     wire1HistogramReset(wire1histogram_t *const hist);
+void     wire1HistogramAdd(
+  wire1histogram_t *const hist,
+  uint16_t const from,
+  uint16_t const to
+);
+uint16_t wire1HistogramPercentile(
+  const wire1histogram_t *const hist,
+  uint8_t const percent
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,340 @@
+#include "one-wire.h"
+#include "one-wire-slave.h"
+
+#ifdef W1_BACKEND_EXTERN
+  #error The slave drives the wire with the AVR pin functions of one-wire.c
+#endif
+
+// Number of polling loops in wire1Poll4Hold/wire1Poll4Release (4 cycles
+// each) that corresponds to a time in us
+#define W1_SLAVE_LOOPS(us)  ((uint16_t)((us) * ((F_CPU + 500000UL) / 1000000UL) / 4))
+
+/** What the slave expects of the next slot */
+enum wire1slavephase_t {
+  // Waiting for a reset
+  W1S_IDLE,
+  // Receiving a ROM command
+  W1S_ROM_COMMAND,
+  // Taking part in (alarm) search, three slots per ROM bit
+  W1S_SEARCH,
+  // Receiving the ROM address to match
+  W1S_MATCH,
+  // Receiving a function command
+  W1S_FUNCTION,
+  // Sending bytes set up with wire1SlaveTransmit
+  W1S_TRANSMIT,
+  // Receiving bytes set up with wire1SlaveReceive
+  W1S_RECEIVE
+};
+
+static uint8_t (*wire1_slaveRoms)[8];
+static uint8_t wire1_slaveRomCount;
+static wire1SlaveFunction_t wire1_slaveFunction;
+static volatile uint8_t wire1_slaveAlarms;
+
+static enum wire1slavephase_t wire1_slavePhase = W1S_IDLE;
+static enum wire1slavephase_t wire1_slaveNextPhase;
+// Bit mask of the virtual ROMs that are still addressed
+static uint8_t wire1_slaveActive;
+// Set if a '0' shall be sent in the next slot
+static uint8_t wire1_slaveSendZero;
+// Set if the next falling edge is our own presence pulse
+static uint8_t wire1_slaveOwnEdge;
+
+// Bit position in the current byte, or in the ROM when searching
+static uint8_t wire1_slaveBit;
+// Slot within the current search bit (0 - bit, 1 - complement, 2 - direction)
+static uint8_t wire1_slaveSearchSlot;
+static uint8_t wire1_slaveByte;
+
+// Current transfer
+static uint8_t *wire1_slaveData;
+static uint8_t wire1_slaveSize;
+static uint8_t wire1_slavePos;
+static wire1SlaveDone_t wire1_slaveDone;
+
+/**
+ * Sets up the slave. Interrupts for the wire shall be enabled after this.
+ * @param  roms      The ROM addresses (including CRC) to answer for
+ * @param  count     Number of ROM addresses (at most W1_SLAVE_MAX_ROMS)
+ * @param  function  Called when a function command has been received
+ */
+void wire1SlaveInit(
+  uint8_t (*const roms)[8],
+  uint8_t const count,
+  wire1SlaveFunction_t const function
+) {
+  wire1_slaveRoms = roms;
+  wire1_slaveRomCount = count < W1_SLAVE_MAX_ROMS ? count : W1_SLAVE_MAX_ROMS;
+  wire1_slaveFunction = function;
+  wire1_slaveAlarms = 0;
+  wire1_slavePhase = W1S_IDLE;
+  wire1_slaveSendZero = 0;
+  wire1_slaveOwnEdge = 0;
+  wire1Release();
+}
+
+/**
+ * Sets whether a virtual ROM takes part in alarm searches
+ * @param  rom    Index of the virtual ROM
+ * @param  alarm  [boolean] Whether the alarm condition is met
+ */
+void wire1SlaveSetAlarm(uint8_t const rom, uint8_t const alarm) {
+  if (alarm) {
+    wire1_slaveAlarms |= BV(rom);
+  } else {
+    wire1_slaveAlarms &= ~BV(rom);
+  }
+}
+
+/**
+ * Sets up bytes to send to the master in the following read slots. Shall be
+ * called from the function callback.
+ * @param  data  The bytes to send (must be kept until they are sent)
+ * @param  size  Number of bytes
+ */
+void wire1SlaveTransmit(const uint8_t *const data, uint8_t const size) {
+  if (!size)
+    return;
+  wire1_slaveData = (uint8_t *)data;
+  wire1_slaveSize = size;
+  wire1_slavePos = 0;
+  wire1_slaveBit = 0;
+  wire1_slavePhase = W1S_TRANSMIT;
+  wire1_slaveNextPhase = W1S_IDLE;
+}
+
+/**
+ * Sets up a buffer for bytes that the master writes in the following slots.
+ * Shall be called from the function callback.
+ * @param  data  Where to store the received bytes
+ * @param  size  Number of bytes
+ * @param  done  Called when all bytes have been received (may be NULL)
+ */
+void wire1SlaveReceive(
+  uint8_t *const data,
+  uint8_t const size,
+  wire1SlaveDone_t const done
+) {
+  if (!size)
+    return;
+  wire1_slaveData = data;
+  wire1_slaveSize = size;
+  wire1_slavePos = 0;
+  wire1_slaveBit = 0;
+  wire1_slaveDone = done;
+  wire1_slavePhase = W1S_RECEIVE;
+}
+
+/**
+ * Holds the wire for a number of polling loops
+ * @param  loops  Number of loops, see W1_SLAVE_LOOPS
+ */
+static void wire1SlaveHoldFor(uint16_t loops) {
+  wire1Hold();
+  // Will not exit early, since we hold the wire
+  while (loops > 255) {
+    wire1Poll4Release(255);
+    loops -= 255;
+  }
+  wire1Poll4Release(loops);
+  wire1Release();
+}
+
+/**
+ * Measures how long the wire stays low
+ * @return  The time in polling loops, see W1_SLAVE_LOOPS
+ */
+static uint16_t wire1SlaveMeasureLow(void) {
+  uint16_t loops = 0;
+  uint8_t n;
+  do {
+    n = wire1Poll4Release(255);
+    loops += n ? n : 255;
+  } while (!n && loops < W1_SLAVE_LOOPS(2 * W1_SLAVE_RESET_US));
+  return loops;
+}
+
+/**
+ * Handles a received ROM command
+ * @param  command  The ROM command
+ */
+static void wire1SlaveRomCommand(uint8_t const command) {
+  switch (command) {
+  case W1_ROMCMD_ALARM:
+    wire1_slaveActive &= wire1_slaveAlarms;
+    // Fall through
+  case W1_ROMCMD_SEARCH:
+    wire1_slaveBit = 0;
+    wire1_slaveSearchSlot = 0;
+    wire1_slavePhase = wire1_slaveActive ? W1S_SEARCH : W1S_IDLE;
+    break;
+  case W1_ROMCMD_MATCH:
+    wire1_slavePos = 0;
+    wire1_slavePhase = W1S_MATCH;
+    break;
+  case W1_ROMCMD_SKIP:
+    wire1_slavePhase = W1S_FUNCTION;
+    break;
+  case W1_ROMCMD_READ:
+    // Only meaningful with a single ROM, the others are not answered
+    wire1_slaveActive = BV(0);
+    wire1SlaveTransmit(wire1_slaveRoms[0], 8);
+    wire1_slaveNextPhase = W1S_FUNCTION;
+    break;
+  default:
+    wire1_slavePhase = W1S_IDLE;
+  }
+}
+
+/**
+ * Handles a completely received byte
+ * @param  byte  The received byte
+ */
+static void wire1SlaveByte(uint8_t const byte) {
+  switch (wire1_slavePhase) {
+  case W1S_ROM_COMMAND:
+    wire1SlaveRomCommand(byte);
+    break;
+  case W1S_MATCH:
+    for (int i = 0; i < wire1_slaveRomCount; i++) {
+      if (wire1_slaveRoms[i][wire1_slavePos] != byte) {
+        wire1_slaveActive &= ~BV(i);
+      }
+    }
+    if (!wire1_slaveActive) {
+      wire1_slavePhase = W1S_IDLE;
+    } else if (++wire1_slavePos == 8) {
+      wire1_slavePhase = W1S_FUNCTION;
+    }
+    break;
+  case W1S_FUNCTION:
+    // The callback sets up the next phase, if any
+    wire1_slavePhase = W1S_IDLE;
+    wire1_slaveFunction(wire1_slaveActive, byte);
+    break;
+  case W1S_RECEIVE:
+    wire1_slaveData[wire1_slavePos++] = byte;
+    if (wire1_slavePos == wire1_slaveSize) {
+      wire1_slavePhase = W1S_IDLE;
+      if (wire1_slaveDone)
+        wire1_slaveDone(wire1_slaveActive);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+/**
+ * Handles a search slot
+ * @param  bit  The bit written by the master (only used in the third slot)
+ */
+static void wire1SlaveSearch(uint8_t const bit) {
+  if (++wire1_slaveSearchSlot < 3)
+    return;
+  wire1_slaveSearchSlot = 0;
+
+  // Drop the ROMs that are not in the chosen direction
+  for (int i = 0; i < wire1_slaveRomCount; i++) {
+    uint8_t romBit = wire1_slaveRoms[i][wire1_slaveBit/8] & BV(wire1_slaveBit%8);
+    if (!romBit != !bit) {
+      wire1_slaveActive &= ~BV(i);
+    }
+  }
+  if (!wire1_slaveActive) {
+    wire1_slavePhase = W1S_IDLE;
+  } else if (++wire1_slaveBit == 64) {
+    wire1_slaveBit = 0;
+    wire1_slavePhase = W1S_FUNCTION;
+  }
+}
+
+/**
+ * Decides if a '0' shall be sent in the next slot
+ * @return  [boolean] Whether to hold the wire in the next slot
+ */
+static uint8_t wire1SlaveNextZero(void) {
+  if (wire1_slavePhase == W1S_TRANSMIT) {
+    return !(wire1_slaveData[wire1_slavePos] & BV(wire1_slaveBit));
+  } else if (wire1_slavePhase == W1S_SEARCH && wire1_slaveSearchSlot < 2) {
+    // Wired AND of the ROM bits (first slot) or their complements (second
+    // slot) of all ROMs that are still taking part
+    for (int i = 0; i < wire1_slaveRomCount; i++) {
+      if (!(wire1_slaveActive & BV(i)))
+        continue;
+      uint8_t romBit = wire1_slaveRoms[i][wire1_slaveBit/8] & BV(wire1_slaveBit%8);
+      if (!romBit == !wire1_slaveSearchSlot)
+        return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Resets the slave and sends a presence pulse
+ */
+static void wire1SlavePresence(void) {
+  wire1Poll4Hold(W1_SLAVE_LOOPS(W1_SLAVE_PRESENCE_WAIT_US));
+  wire1SlaveHoldFor(W1_SLAVE_LOOPS(W1_SLAVE_PRESENCE_US));
+  wire1_slaveOwnEdge = 1;
+
+  wire1_slaveActive = BV(wire1_slaveRomCount) - 1;
+  wire1_slaveBit = 0;
+  wire1_slaveByte = 0;
+  wire1_slavePhase = W1S_ROM_COMMAND;
+}
+
+/**
+ * Handles one slot. Shall be called from the interrupt on a falling edge of
+ * the wire, as early as possible.
+ */
+void wire1SlaveOnFall(void) {
+  // Answer a read slot before anything else
+  if (wire1_slaveSendZero) {
+    wire1SlaveHoldFor(W1_SLAVE_LOOPS(W1_SLAVE_HOLD_US));
+  }
+  if (wire1_slaveOwnEdge) {
+    wire1_slaveOwnEdge = 0;
+    return;
+  }
+
+  uint16_t low = wire1SlaveMeasureLow();
+  if (low >= W1_SLAVE_LOOPS(W1_SLAVE_RESET_US)) {
+    wire1SlavePresence();
+    wire1_slaveSendZero = 0;
+    return;
+  }
+  // A short low pulse is a '1' (or a read slot)
+  uint8_t bit = low < W1_SLAVE_LOOPS(W1_SLAVE_SAMPLE_US);
+
+  switch (wire1_slavePhase) {
+  case W1S_IDLE:
+    break;
+  case W1S_SEARCH:
+    wire1SlaveSearch(bit);
+    break;
+  case W1S_TRANSMIT:
+    if (++wire1_slaveBit == 8) {
+      wire1_slaveBit = 0;
+      if (++wire1_slavePos == wire1_slaveSize) {
+        wire1_slaveByte = 0;
+        wire1_slavePhase = wire1_slaveNextPhase;
+      }
+    }
+    break;
+  default:
+    // Receiving bytes, LSB first
+    if (bit) {
+      wire1_slaveByte |= BV(wire1_slaveBit);
+    }
+    if (++wire1_slaveBit == 8) {
+      uint8_t byte = wire1_slaveByte;
+      wire1_slaveBit = 0;
+      wire1_slaveByte = 0;
+      wire1SlaveByte(byte);
+    }
+  }
+
+  wire1_slaveSendZero = wire1SlaveNextZero();
+}
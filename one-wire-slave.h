@@ -0,0 +1,65 @@
+#ifndef ONE_WIRE_SLAVE_H
+#define ONE_WIRE_SLAVE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Interrupt driven 1-wire slave, which answers for one or more virtual ROMs
+// on the W1_PORT_LETTER/W1_PIN_POS pin. The application sets up an interrupt
+// on falling edges only of the pin (e.g. INT0 in falling edge mode, which also
+// triggers on the edges that the slave drives itself) and calls
+// wire1SlaveOnFall from it. A pin change interrupt does not fit, since it also
+// fires on rising edges, which would be decoded as extra '1' bits.
+// Between the slots the MCU is free.
+// Needs a clock of at least 8 MHz to answer read slots in time.
+
+// Maximum number of virtual ROMs
+#define W1_SLAVE_MAX_ROMS            8
+
+// Slot timing in us, measured from when the interrupt is handled
+#define W1_SLAVE_SAMPLE_US           20
+#define W1_SLAVE_HOLD_US             30
+#define W1_SLAVE_RESET_US            400
+#define W1_SLAVE_PRESENCE_WAIT_US    20
+#define W1_SLAVE_PRESENCE_US         120
+
+/**
+ * Called from the interrupt when a function command has been received, to
+ * set up the transfer that follows with wire1SlaveTransmit/wire1SlaveReceive.
+ * After Skip ROM all virtual ROMs are addressed, so broadcast commands (e.g.
+ * Convert T) shall be carried out for every ROM in the mask.
+ * Must return within the recovery time between two slots.
+ * @param  roms     Bit mask of the addressed virtual ROMs (bit n for ROM n)
+ * @param  command  The function command
+ */
+typedef void (*wire1SlaveFunction_t)(uint8_t roms, uint8_t command);
+
+/**
+ * Called from the interrupt when a transfer set up with wire1SlaveReceive is
+ * complete
+ * @param  roms  Bit mask of the addressed virtual ROMs
+ */
+typedef void (*wire1SlaveDone_t)(uint8_t roms);
+
+void wire1SlaveInit(
+  uint8_t (*const roms)[8],
+  uint8_t const count,
+  wire1SlaveFunction_t const function
+);
+void wire1SlaveSetAlarm(uint8_t const rom, uint8_t const alarm);
+void wire1SlaveTransmit(const uint8_t *const data, uint8_t const size);
+void wire1SlaveReceive(
+  uint8_t *const data,
+  uint8_t const size,
+  wire1SlaveDone_t const done
+);
+void wire1SlaveOnFall(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,256 @@
+#include "one-wire.h"
+#include "one-wire-sniff.h"
+
+// Shortest low pulses, in us, that are a '0' and a reset
+#define W1_SNIFF_BIT0_US             15
+#define W1_SNIFF_RESET_US            400
+#define W1_SNIFF_OD_BIT0_US          2
+#define W1_SNIFF_OD_RESET_US         40
+// Time, in us, from the end of a reset to where a presence pulse may start
+#define W1_SNIFF_PRESENCE_MIN_US     15
+#define W1_SNIFF_PRESENCE_MAX_US     60
+#define W1_SNIFF_OD_PRESENCE_MIN_US  2
+#define W1_SNIFF_OD_PRESENCE_MAX_US  8
+
+#define W1_SNIFF_MASK                (W1_SNIFF_BUFFER_SIZE - 1)
+
+/** What the decoder expects next */
+enum wire1sniffphase_t {
+  // Waiting for a reset
+  W1D_IDLE,
+  // A reset has been seen, possibly followed by a presence pulse
+  W1D_RESET,
+  // Receiving a ROM command
+  W1D_ROM_COMMAND,
+  // Receiving a ROM address (match/read ROM)
+  W1D_ROM,
+  // Following a search, three bits per ROM bit
+  W1D_SEARCH,
+  // Receiving a function command
+  W1D_FUNCTION,
+  // Receiving data after the function command
+  W1D_DATA
+};
+
+// Thresholds in ticks
+static uint16_t wire1_sniffBit0;
+static uint16_t wire1_sniffReset;
+static uint16_t wire1_sniffPresenceMin;
+static uint16_t wire1_sniffPresenceMax;
+
+// State of the edge interrupt
+static uint16_t wire1_sniffFall;
+// Time when the last reset ended
+static uint16_t wire1_sniffRise;
+static uint8_t wire1_sniffAfterReset;
+// Set if the current low pulse is a presence pulse
+static uint8_t wire1_sniffPresencePulse;
+
+// Symbol ring buffer, written by the interrupt and read by the decoder
+static uint8_t wire1_sniffBuffer[W1_SNIFF_BUFFER_SIZE];
+static volatile uint8_t wire1_sniffHead;
+static volatile uint8_t wire1_sniffTail;
+static volatile uint8_t wire1_sniffOverflows;
+
+// State of the decoder
+static enum wire1sniffphase_t wire1_sniffPhase = W1D_IDLE;
+static uint8_t wire1_sniffPresent;
+static uint8_t wire1_sniffBit;
+static uint8_t wire1_sniffByte;
+static uint8_t wire1_sniffSearchSlot;
+static uint8_t wire1_sniffRom[8];
+
+/**
+ * Sets up the listener and clears the buffer
+ * @param  overdrive  [boolean] Whether the bus runs at overdrive speed
+ */
+void wire1SniffInit(uint8_t const overdrive) {
+  wire1_sniffBit0  = (overdrive ? W1_SNIFF_OD_BIT0_US : W1_SNIFF_BIT0_US) *
+                     W1_SNIFF_TICKS_PER_US;
+  wire1_sniffReset = (overdrive ? W1_SNIFF_OD_RESET_US : W1_SNIFF_RESET_US) *
+                     W1_SNIFF_TICKS_PER_US;
+  wire1_sniffPresenceMin = (overdrive ? W1_SNIFF_OD_PRESENCE_MIN_US :
+                            W1_SNIFF_PRESENCE_MIN_US) * W1_SNIFF_TICKS_PER_US;
+  wire1_sniffPresenceMax = (overdrive ? W1_SNIFF_OD_PRESENCE_MAX_US :
+                            W1_SNIFF_PRESENCE_MAX_US) * W1_SNIFF_TICKS_PER_US;
+  wire1_sniffAfterReset = 0;
+  wire1_sniffPresencePulse = 0;
+  wire1_sniffHead = 0;
+  wire1_sniffTail = 0;
+  wire1_sniffOverflows = 0;
+  wire1_sniffPhase = W1D_IDLE;
+}
+
+/**
+ * Handles an edge on the wire. Shall be called from the interrupt.
+ * @param  ticks  Timer value when the edge happened
+ * @param  high   [boolean] Whether the wire went high (otherwise low)
+ */
+void wire1SniffOnEdge(uint16_t const ticks, uint8_t const high) {
+  if (!high) {
+    // Only a low pulse that starts in the presence window after a reset is a
+    // presence pulse. A later one is the first slot of the master, when no
+    // slave responded.
+    if (wire1_sniffAfterReset) {
+      uint16_t wait = ticks - wire1_sniffRise;
+      wire1_sniffPresencePulse = wait >= wire1_sniffPresenceMin &&
+                                 wait <= wire1_sniffPresenceMax;
+      wire1_sniffAfterReset = 0;
+    }
+    wire1_sniffFall = ticks;
+    return;
+  }
+
+  uint16_t low = ticks - wire1_sniffFall;
+  uint8_t symbol;
+  if (low >= wire1_sniffReset) {
+    symbol = W1_SNIFF_RESET;
+    wire1_sniffRise = ticks;
+    wire1_sniffAfterReset = 1;
+  } else if (wire1_sniffPresencePulse) {
+    symbol = W1_SNIFF_PRESENCE;
+  } else {
+    symbol = low >= wire1_sniffBit0 ? W1_SNIFF_BIT0 : W1_SNIFF_BIT1;
+  }
+  wire1_sniffPresencePulse = 0;
+
+  uint8_t head = wire1_sniffHead;
+  uint8_t next = (head + 1) & W1_SNIFF_MASK;
+  if (next == wire1_sniffTail) {
+    if (wire1_sniffOverflows < UINT8_MAX)
+      wire1_sniffOverflows++;
+    return;
+  }
+  wire1_sniffBuffer[head] = symbol;
+  wire1_sniffHead = next;
+}
+
+/**
+ * @return  Number of symbols lost since wire1SniffInit because the buffer was
+ *          full (saturates)
+ */
+uint8_t wire1SniffOverflows(void) {
+  return wire1_sniffOverflows;
+}
+
+/**
+ * Handles a complete byte in the decoder
+ * @param  event  Where to put the decoded event
+ * @return        1 if an event was decoded; otherwise 0
+ */
+static uint8_t wire1SniffByte(wire1sniffevent_t *const event) {
+  uint8_t byte = wire1_sniffByte;
+  wire1_sniffByte = 0;
+  event->value = byte;
+
+  switch (wire1_sniffPhase) {
+  case W1D_ROM_COMMAND:
+    event->type = W1_SNIFF_EV_ROM_COMMAND;
+    if (byte == W1_ROMCMD_MATCH || byte == W1_ROMCMD_READ) {
+      wire1_sniffPhase = W1D_ROM;
+    } else if (byte == W1_ROMCMD_SEARCH || byte == W1_ROMCMD_ALARM) {
+      wire1_sniffSearchSlot = 0;
+      wire1_sniffPhase = W1D_SEARCH;
+    } else if (byte == W1_ROMCMD_SKIP) {
+      wire1_sniffPhase = W1D_FUNCTION;
+    } else {
+      wire1_sniffPhase = W1D_IDLE;
+    }
+    return 1;
+  case W1D_ROM:
+    wire1_sniffRom[wire1_sniffBit/8 - 1] = byte;
+    if (wire1_sniffBit < 64)
+      return 0;
+    break;
+  case W1D_FUNCTION:
+    event->type = W1_SNIFF_EV_FUNCTION;
+    wire1_sniffPhase = W1D_DATA;
+    return 1;
+  default:
+    event->type = W1_SNIFF_EV_DATA;
+    return 1;
+  }
+
+  // A complete ROM address
+  event->type = W1_SNIFF_EV_ROM;
+  for (int i = 0; i < 8; i++) {
+    event->rom[i] = wire1_sniffRom[i];
+  }
+  event->value = wire1CheckROM(event->rom);
+  wire1_sniffBit = 0;
+  wire1_sniffPhase = W1D_FUNCTION;
+  return 1;
+}
+
+/**
+ * Decodes the buffered symbols until the next event. Shall be called
+ * regularly outside of the interrupt, so that the buffer does not fill up.
+ * @param  event  Where to put the decoded event
+ * @return        1 if an event was decoded; 0 if more symbols are needed
+ */
+uint8_t wire1SniffDecode(wire1sniffevent_t *const event) {
+  while (wire1_sniffTail != wire1_sniffHead) {
+    uint8_t symbol = wire1_sniffBuffer[wire1_sniffTail];
+
+    if (wire1_sniffPhase == W1D_RESET) {
+      // No slave responded if the reset is followed directly by a slot or
+      // another reset. The master may go on anyway, so the symbol is left for
+      // the ROM command.
+      wire1_sniffPresent = (symbol == W1_SNIFF_PRESENCE);
+      if (wire1_sniffPresent)
+        wire1_sniffTail = (wire1_sniffTail + 1) & W1_SNIFF_MASK;
+      wire1_sniffPhase = W1D_ROM_COMMAND;
+      wire1_sniffBit = 0;
+      wire1_sniffByte = 0;
+      event->type = W1_SNIFF_EV_RESET;
+      event->value = wire1_sniffPresent;
+      return 1;
+    }
+    wire1_sniffTail = (wire1_sniffTail + 1) & W1_SNIFF_MASK;
+
+    if (symbol == W1_SNIFF_RESET) {
+      wire1_sniffPhase = W1D_RESET;
+      wire1_sniffPresent = 0;
+      continue;
+    }
+    if (wire1_sniffPhase == W1D_IDLE || symbol == W1_SNIFF_PRESENCE)
+      continue;
+
+    uint8_t bit = symbol == W1_SNIFF_BIT1;
+    if (wire1_sniffPhase == W1D_SEARCH) {
+      // Only the third bit of each ROM bit (the chosen direction) matters
+      if (++wire1_sniffSearchSlot < 3)
+        continue;
+      wire1_sniffSearchSlot = 0;
+      if (bit) {
+        wire1_sniffRom[wire1_sniffBit/8] |= BV(wire1_sniffBit%8);
+      } else {
+        wire1_sniffRom[wire1_sniffBit/8] &= ~BV(wire1_sniffBit%8);
+      }
+      if (++wire1_sniffBit == 64) {
+        wire1_sniffBit = 0;
+        event->type = W1_SNIFF_EV_ROM;
+        for (int i = 0; i < 8; i++) {
+          event->rom[i] = wire1_sniffRom[i];
+        }
+        event->value = wire1CheckROM(event->rom);
+        wire1_sniffPhase = W1D_FUNCTION;
+        return 1;
+      }
+      continue;
+    }
+
+    // Bytes, LSB first. Keep counting bits over the ROM address.
+    if (bit) {
+      wire1_sniffByte |= BV(wire1_sniffBit%8);
+    }
+    wire1_sniffBit++;
+    if (wire1_sniffBit % 8 == 0) {
+      if (wire1_sniffPhase != W1D_ROM)
+        wire1_sniffBit = 0;
+      if (wire1SniffByte(event))
+        return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,59 @@
+#ifndef ONE_WIRE_SNIFF_H
+#define ONE_WIRE_SNIFF_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Passive listener that decodes the traffic of another master. The
+// application timestamps every edge of the wire with a free running timer
+// (e.g. input capture, or a pin change interrupt reading the timer) and calls
+// wire1SniffOnEdge from the interrupt. That only classifies the low pulse and
+// puts a symbol in a ring buffer, and wire1SniffDecode turns the symbols into
+// transactions outside of the interrupt.
+
+// Number of timer ticks per us
+#ifndef W1_SNIFF_TICKS_PER_US
+  #define W1_SNIFF_TICKS_PER_US      1
+#endif
+
+// Size of the symbol ring buffer (a power of two, at most 256)
+#ifndef W1_SNIFF_BUFFER_SIZE
+  #define W1_SNIFF_BUFFER_SIZE       64
+#endif
+
+// Symbols in the ring buffer, one per low pulse on the wire
+#define W1_SNIFF_BIT0                0
+#define W1_SNIFF_BIT1                1
+#define W1_SNIFF_RESET               2
+#define W1_SNIFF_PRESENCE            3
+
+// Decoded events
+#define W1_SNIFF_EV_RESET            0 // value: 1 if a slave was present
+#define W1_SNIFF_EV_ROM_COMMAND      1 // value: the ROM command
+#define W1_SNIFF_EV_ROM              2 // value: 1 if the CRC matched; rom
+#define W1_SNIFF_EV_FUNCTION         3 // value: the function command
+#define W1_SNIFF_EV_DATA             4 // value: a byte read or written
+
+/** A decoded part of a transaction */
+typedef struct {
+  /** Kind of event (W1_SNIFF_EV_*) */
+  uint8_t type;
+  /** Value of the event, see W1_SNIFF_EV_* */
+  uint8_t value;
+  /** The addressed, searched or read ROM for W1_SNIFF_EV_ROM */
+  uint8_t rom[8];
+} wire1sniffevent_t;
+
+void    wire1SniffInit(uint8_t const overdrive);
+void    wire1SniffOnEdge(uint16_t const ticks, uint8_t const high);
+uint8_t wire1SniffOverflows(void);
+uint8_t wire1SniffDecode(wire1sniffevent_t *const event);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,97 @@
+// Host fake of the slots of the timer backend, see one-wire-timer-fake.h
+#include "one-wire.h"
+#include "one-wire-timer-fake.h"
+
+static const uint8_t *wire1_fakeScript;
+static uint16_t wire1_fakeScriptSize;
+static wire1fakeslot_t wire1_fakeLog[W1_TIMER_FAKE_LOG_SIZE];
+// Number of slots run, which is also the position in the script
+static uint16_t wire1_fakeCount;
+// Number of slots in the log
+static uint16_t wire1_fakeLogged;
+
+/**
+ * Clears the log and sets the script that the slaves follow
+ * @param  script  The level that the slaves leave the wire at in each slot
+ *                 from now on, 0 for held low (e.g. a presence pulse or a
+ *                 read '0'); NULL for no slaves
+ * @param  count   Number of slots in the script. The wire is left high by the
+ *                 slaves after that.
+ */
+void wire1TimerFakeInit(const uint8_t *const script, uint16_t const count) {
+  wire1_fakeScript = script;
+  wire1_fakeScriptSize = script ? count : 0;
+  wire1_fakeCount = 0;
+  wire1_fakeLogged = 0;
+}
+
+/**
+ * @return  Number of slots run since wire1TimerFakeInit (saturates)
+ */
+uint16_t wire1TimerFakeCount(void) {
+  return wire1_fakeCount;
+}
+
+/**
+ * @return  [boolean] Whether more slots have been run than fit in the log, so
+ *          that only the first W1_TIMER_FAKE_LOG_SIZE slots are logged
+ */
+uint8_t wire1TimerFakeTruncated(void) {
+  return wire1_fakeCount > wire1_fakeLogged;
+}
+
+/** @return  The logged slots */
+const wire1fakeslot_t *wire1TimerFakeLog(void) {
+  return wire1_fakeLog;
+}
+
+/**
+ * Decodes the byte that the master wrote in eight logged slots, LSB first
+ * @param  first  Index of the first slot of the byte in the log
+ * @return        The byte; -1 if the log does not hold eight slots from there
+ */
+int16_t wire1TimerFakeWritten(uint16_t const first) {
+  if (first + 8 > wire1_fakeLogged)
+    return -1;
+  uint8_t writtenByte = 0;
+  for (int i = 0; i < 8; i++) {
+    if (wire1_fakeLog[first + i].lowUs < W1_TIMER_SAMPLE_US) {
+      writtenByte |= BV(i);
+    }
+  }
+  return writtenByte;
+}
+
+/**
+ * Runs the slots against the script instead of a wire, see one-wire-timer.h.
+ * The wire is sampled low where the master still drives it, and at the level
+ * of the script otherwise.
+ */
+void wire1TimerSlots(
+  uint16_t const slotUs,
+  const uint16_t *const lowUs,
+  uint16_t const sampleUs,
+  uint8_t *const levels,
+  uint8_t const count
+) {
+  for (int i = 0; i < count; i++) {
+    uint16_t slot = wire1_fakeCount;
+    uint8_t level = 1;
+    if (lowUs[i] > sampleUs) {
+      level = 0;
+    } else if (slot < wire1_fakeScriptSize) {
+      level = wire1_fakeScript[slot] ? 1 : 0;
+    }
+    levels[i] = level;
+
+    // The script goes on when the log is full
+    if (wire1_fakeCount < UINT16_MAX)
+      wire1_fakeCount++;
+    if (slot < W1_TIMER_FAKE_LOG_SIZE) {
+      wire1_fakeLog[slot].slotUs = slotUs;
+      wire1_fakeLog[slot].lowUs  = lowUs[i];
+      wire1_fakeLog[slot].level  = level;
+      wire1_fakeLogged++;
+    }
+  }
+}
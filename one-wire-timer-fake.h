@@ -0,0 +1,38 @@
+#ifndef ONE_WIRE_TIMER_FAKE_H
+#define ONE_WIRE_TIMER_FAKE_H
+
+#include <stdint.h>
+#include "one-wire-timer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Host fake of wire1TimerSlots, for running the timer backend and the library
+// on top of it without hardware, e.g. to check the bit packing of the byte
+// transfers. Every slot is logged, and the slaves are played by a script with
+// the level that they leave the wire at in the sample point of each slot.
+
+// Number of slots that are logged
+#define W1_TIMER_FAKE_LOG_SIZE       256
+
+/** One logged slot */
+typedef struct {
+  uint16_t slotUs;
+  /** Time that the master drove the wire low */
+  uint16_t lowUs;
+  /** The level that was sampled, non-zero if the wire was high */
+  uint8_t level;
+} wire1fakeslot_t;
+
+void     wire1TimerFakeInit(const uint8_t *const script, uint16_t const count);
+uint16_t wire1TimerFakeCount(void);
+uint8_t  wire1TimerFakeTruncated(void);
+const wire1fakeslot_t *wire1TimerFakeLog(void);
+int16_t  wire1TimerFakeWritten(uint16_t const first);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,77 @@
+// Backend that produces the slots with a timer and DMA, for 32-bit MCUs. Only
+// the slot encoding is done here, see one-wire-timer.h.
+// The library shall be built with W1_BACKEND_EXTERN and W1_BACKEND_BYTES.
+#include "one-wire.h"
+#include "one-wire-timer.h"
+
+#if !defined(W1_BACKEND_EXTERN) || !defined(W1_BACKEND_BYTES)
+  #error The timer backend needs W1_BACKEND_EXTERN and W1_BACKEND_BYTES
+#endif
+
+/**
+ * Resets all 1-wire devices and checks if there are any slaves that responds
+ * @return  0 if no slave responds, 1 if a slave responds
+ */
+int8_t wire1ResetPulse(void) {
+  const uint16_t low = W1_TIMER_RESET_LOW_US;
+  uint8_t level;
+  wire1TimerSlots(W1_TIMER_RESET_SLOT_US, &low, W1_TIMER_PRESENCE_SAMPLE_US,
+                  &level, 1);
+  // A slave responds by holding the wire low
+  return level ? 0 : 1;
+}
+
+/**
+ * Forces slaves into next state and then reads the returned value
+ * @return  0 if sampled low; otherwise 0xFF
+ */
+uint8_t wire1ReadBit(void) {
+  const uint16_t low = W1_TIMER_LOW_1_US;
+  uint8_t level;
+  wire1TimerSlots(W1_TIMER_SLOT_US, &low, W1_TIMER_SAMPLE_US, &level, 1);
+  return level ? 0xFF : 0;
+}
+
+/**
+ * Forces slaves into next state and then send a 1 or 0
+ * @param bit [boolean] Send a 0 if zero, otherwise send 1
+ */
+void wire1WriteBit(uint8_t bit) {
+  const uint16_t low = bit ? W1_TIMER_LOW_1_US : W1_TIMER_LOW_0_US;
+  uint8_t level;
+  wire1TimerSlots(W1_TIMER_SLOT_US, &low, W1_TIMER_SAMPLE_US, &level, 1);
+}
+
+/**
+ * Reads a byte over one-wire, LSB first, as one sequence of 8 slots
+ * @return  The value that was read
+ */
+uint8_t wire1ReadByte(void) {
+  uint16_t low[8];
+  uint8_t levels[8];
+  for (int i = 0; i < 8; i++) {
+    low[i] = W1_TIMER_LOW_1_US;
+  }
+  wire1TimerSlots(W1_TIMER_SLOT_US, low, W1_TIMER_SAMPLE_US, levels, 8);
+
+  uint8_t readByte = 0;
+  for (int i = 0; i < 8; i++) {
+    if (levels[i]) {
+      readByte |= BV(i);
+    }
+  }
+  return readByte;
+}
+
+/**
+ * Writes a byte over one-wire, LSB first, as one sequence of 8 slots
+ * @param  writeByte    The byte to write over the wire
+ */
+void wire1WriteByte(uint8_t writeByte) {
+  uint16_t low[8];
+  uint8_t levels[8];
+  for (int i = 0; i < 8; i++) {
+    low[i] = (writeByte & BV(i)) ? W1_TIMER_LOW_1_US : W1_TIMER_LOW_0_US;
+  }
+  wire1TimerSlots(W1_TIMER_SLOT_US, low, W1_TIMER_SAMPLE_US, levels, 8);
+}
@@ -0,0 +1,51 @@
+#ifndef ONE_WIRE_TIMER_H
+#define ONE_WIRE_TIMER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Slot encoding layer for a timer/DMA backend. The library's resets, bits and
+// bytes are turned into sequences of timed slots here, which wire1TimerSlots
+// shall put on the wire. No timer or DMA driver for a specific MCU is part of
+// the library; the application provides wire1TimerSlots for its part (only a
+// host fake, one-wire-timer-fake.c, is included).
+
+// Slot timing in us for the timer backend
+#define W1_TIMER_SLOT_US             70
+#define W1_TIMER_LOW_1_US            6
+#define W1_TIMER_LOW_0_US            60
+#define W1_TIMER_SAMPLE_US           15
+#define W1_TIMER_RESET_SLOT_US       960
+#define W1_TIMER_RESET_LOW_US        480
+#define W1_TIMER_PRESENCE_SAMPLE_US  550
+
+/**
+ * Runs a sequence of slots on the wire with a timer, to be implemented for the
+ * MCU. Typically a timer in PWM mode with the slot length as period, where DMA
+ * loads the compare value (the end of the low pulse) of the next slot, and a
+ * second compare channel triggers DMA of the input register at the sample
+ * time. The CPU is not involved until all slots are done.
+ * one-wire-timer-fake.c implements it for host builds without hardware.
+ *
+ * @param  slotUs    Length of each slot
+ * @param  lowUs     Time to drive the wire low from the start of each slot
+ * @param  sampleUs  Time from the start of each slot to sample the wire at
+ * @param  levels    The sampled levels, non-zero if the wire was high
+ * @param  count     Number of slots
+ */
+void wire1TimerSlots(
+  uint16_t const slotUs,
+  const uint16_t *const lowUs,
+  uint16_t const sampleUs,
+  uint8_t *const levels,
+  uint8_t const count
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,7 +1,12 @@
+#ifndef W1_BACKEND_EXTERN
 // For pin definitions
 #include <avr/io.h>
+#include <avr/sleep.h>
+#endif
+#include <stddef.h>
 #include "one-wire.h"
 
+#ifndef W1_BACKEND_EXTERN
 // MACROS for being able to use convenient W1_-"variables
 #ifndef W1_PORT_LETTER
   #warning W1_PORT_LETTER needs to be defined to be able to resolve \
@@ -25,8 +30,42 @@
 // Adding 1/2 MHz to make rounding correct.
 #define F_CPU_TIME_FACTOR ((F_CPU + 500000UL) / 1000000UL)
 
+// The sleep mode used while waiting for slaves. Must keep the wake-up source
+// that the application has set up running.
+#ifndef W1_SLEEP_MODE
+  #define W1_SLEEP_MODE   SLEEP_MODE_IDLE
+#endif
+
+// The pins of W1_PORT_LETTER that have a bus each, for synchronised
+// conversions on all of them and reading them out one by one (see
+// wire1SyncConvertT and wire1SyncReadScratchPad)
+#ifndef W1_SYNC_PIN_MASK
+  #define W1_SYNC_PIN_MASK  BV(W1_PIN_POS)
+#endif
+#endif
+
+#ifndef W1_BACKEND_EXTERN
 static enum wire1state_t wire1state = IDLE;
 static uint16_t wire1_idleloops = 0;
+#else
+// With a backend there may be many buses, selected one at a time. With
+// W1_BACKEND_THREADS they may also be run from several threads, and each
+// thread works on the bus whose context it has selected, or on a context of
+// its own if none is selected. Otherwise plain statics are used, since thread
+// local storage is usually not available on bare-metal MCUs.
+#ifdef W1_BACKEND_THREADS
+  #define W1_THREAD_LOCAL _Thread_local
+#else
+  #define W1_THREAD_LOCAL
+#endif
+static W1_THREAD_LOCAL wire1context_t wire1_threadContext;
+static W1_THREAD_LOCAL wire1context_t *wire1_context;
+static inline wire1context_t *wire1CurrentContext(void) {
+  return wire1_context ? wire1_context : &wire1_threadContext;
+}
+#define wire1state      (wire1CurrentContext()->state)
+#define wire1_idleloops (wire1CurrentContext()->idleloops)
+#endif
 uint16_t wire1Poll4Idle(void);
 static int8_t wire1Search(
   uint8_t * addrOut,
@@ -43,6 +82,28 @@ enum wire1state_t wire1GetState(void) {
   return wire1state;
 }
 
+#ifdef W1_BACKEND_EXTERN
+/**
+ * Selects the bus that the calling thread works on. With W1_BACKEND_THREADS a
+ * bus may be moved to another thread by selecting its context there, but shall
+ * only be used by one thread at a time.
+ * @param  context  The context of the bus; NULL for the thread's own context
+ */
+void wire1SetContext(wire1context_t *const context) {
+  wire1_context = context;
+}
+
+/**
+ * Function for returning the bus that the calling thread works on, e.g. for a
+ * backend to find the bus that it shall drive
+ * @return  The context of the bus
+ */
+wire1context_t *wire1GetContext(void) {
+  return wire1CurrentContext();
+}
+#endif
+
+#ifndef W1_BACKEND_EXTERN
 /**
  * Hold the wire down (drives it low).
  */
@@ -60,6 +121,15 @@ inline void wire1Release(void) {
   CONCAT_EXPAND(PORT, W1_PORT_LETTER) |=  BV(W1_PIN_POS); // Add pullup
 }
 
+/**
+ * Drives the wire high, to supply parasite powered slaves with enough current
+ * during e.g. conversions. Ended with wire1Release.
+ */
+inline void wire1StrongPullUp(void) {
+  CONCAT_EXPAND(PORT, W1_PORT_LETTER) |=  BV(W1_PIN_POS); // Drive high
+  CONCAT_EXPAND(DDR,  W1_PORT_LETTER) |=  BV(W1_PIN_POS); // Pin as output
+}
+
 /**
  * Polls the wire a number of times, or until someone drives it low
  * Cycles taken for a complete function call:
@@ -127,6 +197,7 @@ uint8_t wire1Poll4Release(uint8_t nloops) {
   );
   return nloops;
 }
+#endif
 
 /**
  * Polls the wire slaves a number of times, or until no slaves respond with 0.
@@ -165,10 +236,54 @@ void wire1SetupPoll4Idle(uint16_t nloops) {
   wire1_idleloops = nloops;
 }
 
+#ifndef W1_BACKEND_EXTERN
+/**
+ * Same as wire1Poll4Idle, but puts the MCU to sleep (W1_SLEEP_MODE) between
+ * the polls instead of spinning. wire1SetupPoll4Idle must be run before this
+ * function, and the nloops given to it is here the number of wake-ups to wait
+ * for. The application shall set up the wake-up source (e.g. a timer or the
+ * watchdog interrupt) and enable interrupts.
+ * With the strong pull-up the slaves cannot be polled, since the wire is held
+ * high all the time; the wire is then released after the last wake-up. The
+ * slaves need the pull-up within 10 us of the last slot of the command, which
+ * is too soon to get here at 1 MHz, so let wire1ConvertT apply it.
+ * An nloops of 0 given to wire1SetupPoll4Idle returns 0 at once, the same as a
+ * timeout.
+ *
+ * @param  strongPullUp  [boolean] Hold the strong pull-up while sleeping
+ * @return               0 if the slaves never responded with '1', otherwise
+ *                       the number of wake-ups before the wire went idle
+ */
+uint16_t wire1SleepPoll4Idle(uint8_t strongPullUp) {
+  uint16_t i;
+  if (strongPullUp) {
+    // First of all, since the slaves need the current within 10 us
+    wire1StrongPullUp();
+    set_sleep_mode(W1_SLEEP_MODE);
+    for (i = 0; i < wire1_idleloops; i++) {
+      sleep_mode();
+    }
+    wire1Release();
+    wire1state = IDLE;
+    return i;
+  }
+
+  set_sleep_mode(W1_SLEEP_MODE);
+  for (i = 1; i <= wire1_idleloops; i++) {
+    sleep_mode();
+    // Check if the slaves are done when woken up
+    if (wire1ReadBit()) {
+      wire1state = IDLE;
+      return i;
+    }
+  }
+  // Timeout! The wire never went to IDLE state
+  return 0;
+}
+#endif
+
 /**
  * Resets all 1-wire devices and checks if there are any slaves that responds.
- * The time of the last sample is written within parentheses as comments after
- * the poll calls. The total time for the function call is written after that.
  *
  * @return  negative if error, 0 if no slave responds, 1 if a slave responds
  */
@@ -177,6 +292,21 @@ int8_t wire1Reset(void) {
   if (wire1state == WAIT_POLL && wire1Poll4Idle() == 0) {
     return -3;
   }
+  int8_t presence = wire1ResetPulse();
+  wire1state = (presence == 1) ? ROM_COMMAND : IDLE;
+  return presence;
+}
+
+#ifndef W1_BACKEND_EXTERN
+/**
+ * Sends the reset pulse and checks for a presence pulse, without touching the
+ * state of the interface.
+ * The time of the last sample is written within parentheses as comments after
+ * the poll calls. The total time for the function call is written after that.
+ *
+ * @return  negative if error, 0 if no slave responds, 1 if a slave responds
+ */
+int8_t wire1ResetPulse(void) {
   // Hold for 450+ us to reset
   wire1Hold();
   // Use our own precision delay (will not exit early, since we hold the wire)
@@ -185,19 +315,15 @@ int8_t wire1Reset(void) {
 
   // Check if there is a response within 60 us
   if (!wire1Poll4Hold(15)) { // (66) 74 us = 4*15 + 14
-    wire1state = IDLE;
     return 0;
   }
 
   // Wire shall be held by slave for 60-240 us
   if (!wire1Poll4Release(60)) { // (246) 254 us = 4*60 + 14
-    wire1state = IDLE;
     return -1; // The wire was never released
   } else if (wire1Poll4Hold(58)) { // Wait out the rest of the slot
-    wire1state = IDLE;
     return -2;
   } else {
-    wire1state = ROM_COMMAND;
     return 1; // Success!
   }
 }
@@ -261,7 +387,9 @@ void wire1WriteBit(uint8_t bit) {
   }
   asm volatile("nop");
 }
+#endif
 
+#ifndef W1_BACKEND_BYTES
 /**
  * Reads a byte over one-wire, LSB first
  * @return  The value that was read
@@ -285,6 +413,123 @@ void wire1WriteByte(uint8_t writeByte) {
     wire1WriteBit(writeByte & BV(i));
   }
 }
+#endif
+
+#ifndef W1_BACKEND_EXTERN
+/**
+ * Writes a byte over one-wire, LSB first, and drives the wire high straight
+ * out of the last slot, since parasite powered slaves need the strong pull-up
+ * within 10 us after e.g. Convert T or Copy Scratchpad. Ended with
+ * wire1Release.
+ * @param  writeByte    The byte to write over the wire
+ */
+void wire1WriteBytePullUp(uint8_t writeByte) {
+  for (int i = 0; i < 7; i++) {
+    wire1WriteBit(writeByte & BV(i));
+  }
+
+  // The wire is already held, so driving the pin high is a single write
+  wire1Hold();
+  if (writeByte & BV(7)) {
+    asm volatile("nop\n\t" : : ); // Hold for >1 us
+  } else {
+    wire1Poll4Release(15); // (66) 74 us = 4*15 + 14
+  }
+  wire1StrongPullUp();
+}
+#endif
+
+/**
+ * wire1ReadByte for wire1ReadScatterWith
+ * @param  mask  Not used, the bus is W1_PIN_POS
+ * @return       The value that was read
+ */
+static uint8_t wire1ReadByteOf(uint8_t const mask) {
+  (void)mask;
+  return wire1ReadByte();
+}
+
+/**
+ * wire1WriteByte for wire1WriteAddressWith
+ * @param  mask       Not used, the bus is W1_PIN_POS
+ * @param  writeByte  The byte to write over the wire
+ */
+static void wire1WriteByteOf(uint8_t const mask, uint8_t writeByte) {
+  (void)mask;
+  wire1WriteByte(writeByte);
+}
+
+/**
+ * Reads bytes into a scatter list with the given byte function, so that the
+ * buses of wire1SyncReadScratchPad share the code with wire1ReadScatter
+ * @param  readByte  Reads a byte from the buses of the mask
+ * @param  mask      The buses to read from, passed on to readByte
+ * @param  iov       The list of destinations to read into
+ * @param  count     Number of entries in the list
+ * @return           The CRC of all the read bytes, see wire1ReadScatter
+ */
+static uint8_t wire1ReadScatterWith(
+  uint8_t (*const readByte)(uint8_t const mask),
+  uint8_t const mask,
+  const wire1iovec_t *const iov,
+  uint8_t const count
+) {
+  uint8_t crc = 0;
+  for (int i = 0; i < count; i++) {
+    for (int j = 0; j < iov[i].size; j++) {
+      iov[i].data[j] = readByte(mask);
+      crc = crc8(crc, W1_CRC_POLYNOMIAL, &iov[i].data[j], 1);
+    }
+  }
+  return crc;
+}
+
+/**
+ * Sends Match ROM with an address, or Skip ROM, with the given byte function
+ * @param  writeByte  Writes a byte to the buses of the mask
+ * @param  mask       The buses to write to, passed on to writeByte
+ * @param  addr       Pointer to the ROM address to match; NULL to skip ROM
+ */
+static void wire1WriteAddressWith(
+  void (*const writeByte)(uint8_t const mask, uint8_t writeByte),
+  uint8_t const mask,
+  const uint8_t *const addr
+) {
+  if (!addr) {
+    writeByte(mask, W1_ROMCMD_SKIP);
+    return;
+  }
+  writeByte(mask, W1_ROMCMD_MATCH);
+  for (int i = 0; i < 8; i++) {
+    writeByte(mask, addr[i]);
+  }
+}
+
+/**
+ * Reads bytes over one-wire straight into a scatter list, so that no
+ * intermediate buffer is needed. The entries are filled in order.
+ * @param  iov    The list of destinations to read into
+ * @param  count  Number of entries in the list
+ * @return        The CRC of all the read bytes. Will be 0 if the last read
+ *                byte was a correct CRC of the preceding bytes.
+ */
+uint8_t wire1ReadScatter(const wire1iovec_t *const iov, uint8_t const count) {
+  return wire1ReadScatterWith(wire1ReadByteOf, 0, iov, count);
+}
+
+/**
+ * Writes bytes over one-wire straight from a gather list. The entries are
+ * written in order.
+ * @param  iov    The list of sources to write from
+ * @param  count  Number of entries in the list
+ */
+void wire1WriteGather(const wire1iovec_t *const iov, uint8_t const count) {
+  for (int i = 0; i < count; i++) {
+    for (int j = 0; j < iov[i].size; j++) {
+      wire1WriteByte(iov[i].data[j]);
+    }
+  }
+}
 
 /**
  * Mask out a specific bit in a bit array
@@ -330,65 +575,124 @@ static int8_t wire1Search(
   // Issue the search ROM command to one-wire devices
   wire1WriteByte(rom_command);
 
-  int8_t currConfPos = 64;
-  uint8_t addrAck, addrNAck;
-  uint8_t iByte = -1;
-  uint8_t writeBit;
+  wire1search_t search;
+  wire1SearchBegin(&search, addrOut, addrStart, lastConfPos);
   for (int iBit = 0; iBit < 64; iBit++) {
-    // Go to next byte when bit has "overflowed"
-    if (iBit % 8 == 0) {
-      iByte++;
-      addrOut[iByte] = 0;
-    }
-
     // Read the ACK and NACK bit (ROM bit)
-    addrAck  = wire1ReadBit();
-    addrNAck = wire1ReadBit();
-
-    if (!addrAck && !addrNAck) { // Conflict - driven low both times
-
-      // If at the conflict position, take the other branch,
-      // otherwise keep following the search start direction
-      if (iBit == lastConfPos) {
-        // Previously visited ROM's that were in conflict will have been zero,
-        // since we only search upward
-        writeBit = 1;
-      // -1 means that it is uninitialized => find lowest ROM
-      } else if (lastConfPos == -1) {
-        writeBit = 0;
-      } else {
-        writeBit = maskBitInArray(addrStart, iBit);
-        // There is something to search that has not been searched before in this branch,
-        // so store this location for next search
-        if (!maskBitInArray(addrStart, iBit)) {
-          currConfPos = iBit;
-        }
-      }
-      // Update the output address
-      if (writeBit) {
-        addrOut[iByte] |= BV(iBit%8);
-      }
-      wire1WriteBit(writeBit); // Choose 0 if not supposed to branch yet
-    } else if (addrAck && addrNAck) { // No device responds: strange error!
+    uint8_t addrAck  = wire1ReadBit();
+    uint8_t addrNAck = wire1ReadBit();
+
+    int8_t writeBit = wire1SearchStep(&search, addrAck, addrNAck);
+    if (writeBit < 0) { // No device responds: strange error!
       return -128;
-    } else { // ACK and NACK were different => no discrepancy, just follow along
-      wire1WriteBit(addrAck);
-      if (addrAck) {
-        addrOut[iByte] |= BV(iBit%8);
+    }
+    wire1WriteBit(writeBit);
+  }
+
+  int8_t result = wire1SearchEnd(&search);
+  wire1state = result < 0 ? IDLE : FUNCTION_COMMAND;
+  return result;
+}
+
+/**
+ * Starts a search pass that is driven one ROM bit at a time with
+ * wire1SearchStep, for backends that cannot block in wire1ReadBit (e.g. when
+ * the slots are run asynchronously). The reset and the search command shall be
+ * sent by the caller. The parameters are the same as for wire1SearchLargerROM.
+ *
+ * @param  search       The state of the search pass
+ * @param  addrOut      The output address for the returned ROM (8 bytes)
+ * @param  addrStart    Starting point for searching ROM address from
+ * @param  lastConfPos  The bit position of the conflict bit in the last
+ *                      search (above 63 unsigned if starting a new search)
+ */
+void wire1SearchBegin(
+  wire1search_t *const search,
+  uint8_t *const addrOut,
+  uint8_t *const addrStart,
+  uint8_t const lastConfPos
+) {
+  search->addrOut = addrOut;
+  search->addrStart = addrStart;
+  search->lastConfPos = lastConfPos;
+  search->currConfPos = 64;
+  search->bit = 0;
+  search->romByte = 0;
+}
+
+/**
+ * Decides the branch to take for the next ROM bit of a search pass. Reads the
+ * ACK and NACK of the ROM bit and decides what branch to choose depending on
+ * the conflict position in the last search and the start address.
+ *
+ * @param  search    The state of the search pass
+ * @param  addrAck   The first read bit (the ROM bit)
+ * @param  addrNAck  The second read bit (the complement of the ROM bit)
+ * @return           The bit to write; -128 if no device responded
+ */
+int8_t wire1SearchStep(
+  wire1search_t *const search,
+  uint8_t const addrAck,
+  uint8_t const addrNAck
+) {
+  uint8_t iBit = search->bit;
+  uint8_t lastConfPos = search->lastConfPos;
+  uint8_t writeBit;
+
+  if (!addrAck && !addrNAck) { // Conflict - driven low both times
+
+    // If at the conflict position, take the other branch,
+    // otherwise keep following the search start direction
+    if (iBit == lastConfPos) {
+      // Previously visited ROM's that were in conflict will have been zero,
+      // since we only search upward
+      writeBit = 1;
+    // Past the last conflict, or above 63 when starting a new search
+    // => find lowest ROM in this branch, and come back here next search
+    } else if (lastConfPos > 63 || iBit > lastConfPos) {
+      writeBit = 0;
+      search->currConfPos = iBit;
+    } else {
+      writeBit = maskBitInArray(search->addrStart, iBit) ? 1 : 0;
+      // There is something to search that has not been searched before in this branch,
+      // so store this location for next search
+      if (!writeBit) {
+        search->currConfPos = iBit;
       }
     }
+  } else if (addrAck && addrNAck) { // No device responds: strange error!
+    return -128;
+  } else { // ACK and NACK were different => no discrepancy, just follow along
+    writeBit = addrAck ? 1 : 0;
   }
 
+  // Update the output address
+  if (writeBit) {
+    search->romByte |= BV(iBit%8);
+  }
+  // Store the byte when it is complete. Not earlier, since addrStart may
+  // point to the same location and is still needed for the current byte
+  if (iBit % 8 == 7) {
+    search->addrOut[iBit/8] = search->romByte;
+    search->romByte = 0;
+  }
+  search->bit++;
+  return writeBit;
+}
+
+/**
+ * Finishes a search pass after all 64 ROM bits
+ * @param  search  The state of the search pass
+ * @return         -1 if the CRC of the found ROM did not match (most probably
+ *                 no device was selected), otherwise as wire1SearchLargerROM
+ */
+int8_t wire1SearchEnd(wire1search_t *const search) {
   // Make sure that the ROM was read correctly, otherwise the device will not
   // have been selected
-  if (addrOut[W1_ADDR_BYTE_CRC] == crc8(0, W1_CRC_POLYNOMIAL, addrOut, 7)) {
-    wire1state = FUNCTION_COMMAND;
-    return currConfPos;
-  // CRC did not match. Most probably, no device has been selected
-  } else {
-    wire1state = IDLE;
+  if (search->bit != 64 || !wire1CheckROM(search->addrOut)) {
     return -1;
   }
+  return search->currConfPos;
 }
 
 /**
@@ -465,7 +769,7 @@ int8_t wire1ReadSingleROM(uint8_t *const addr) {
   }
   // Make sure that the ROM was read correctly, otherwise the device will not
   // have been selected
-  if (addr[W1_ADDR_BYTE_CRC] == crc8(0, W1_CRC_POLYNOMIAL, addr, 7)) {
+  if (wire1CheckROM(addr)) {
     wire1state = FUNCTION_COMMAND;
     return 0;
   } else {
@@ -484,10 +788,7 @@ int8_t wire1MatchROM(uint8_t *const addr) {
   wire1Reset();
   if (wire1state != ROM_COMMAND)
     return -1;
-  wire1WriteByte(W1_ROMCMD_MATCH);
-  for (int i = 0; i < 8; i++) {
-    wire1WriteByte(addr[i]);
-  }
+  wire1WriteAddressWith(wire1WriteByteOf, 0, addr);
   wire1state = FUNCTION_COMMAND;
   return 0;
 }
@@ -501,7 +802,7 @@ int8_t wire1SkipROM(void) {
   wire1Reset();
   if (wire1state != ROM_COMMAND)
     return -1;
-  wire1WriteByte(W1_ROMCMD_SKIP);
+  wire1WriteAddressWith(wire1WriteByteOf, 0, NULL);
   wire1state = FUNCTION_COMMAND;
   return 0;
 }
@@ -521,6 +822,492 @@ int8_t wire1ReadPowerSupply(void) {
   return parasite_power;
 }
 
+/**
+ * Starts a temperature conversion in the addressed device(s). The conversion
+ * starts when this function returns, which is where to take a timestamp if
+ * the age of the reading is of interest.
+ * @param  strongPullUp  [boolean] Drive the wire high right after the last
+ *                       slot, for parasite powered devices. Ended with
+ *                       wire1Release (e.g. by wire1SleepPoll4Idle).
+ * @return 0 - OK; -2 if not starting in the correct state; -4 if the strong
+ *         pull-up is not supported (W1_BACKEND_EXTERN)
+ */
+int8_t wire1ConvertT(uint8_t strongPullUp) {
+  if (wire1state != FUNCTION_COMMAND)
+    return -2;
+#ifndef W1_BACKEND_EXTERN
+  if (strongPullUp) {
+    wire1WriteBytePullUp(W1_FUNC_CONVERT_T);
+    wire1state = IDLE;
+    return 0;
+  }
+#else
+  if (strongPullUp)
+    return -4;
+#endif
+  wire1WriteByte(W1_FUNC_CONVERT_T);
+  wire1state = IDLE;
+  return 0;
+}
+
+#ifndef W1_BACKEND_EXTERN
+/**
+ * Holds the buses of the given pins down (drives them low) with one port write
+ * @param  mask  The pins of the buses
+ */
+static inline void wire1SyncHold(uint8_t const mask) {
+  CONCAT_EXPAND(PORT, W1_PORT_LETTER) &= ~mask;
+  CONCAT_EXPAND(DDR,  W1_PORT_LETTER) |=  mask;
+}
+
+/**
+ * Releases the buses of the given pins with one port write
+ * @param  mask  The pins of the buses
+ */
+static inline void wire1SyncRelease(uint8_t const mask) {
+  CONCAT_EXPAND(DDR,  W1_PORT_LETTER) &= ~mask;
+  CONCAT_EXPAND(PORT, W1_PORT_LETTER) |=  mask;
+}
+
+/**
+ * Waits without looking at the wire, since the buses of a mask need not
+ * include W1_PIN_POS that the poll loops watch
+ * Cycles taken for a complete function call: 8 + 4*nloops
+ * @param  nloops  Number of loops (1-255)
+ */
+static void __attribute__((noinline)) wire1SyncDelay(uint8_t nloops) {
+  asm volatile(
+    "loop%=:"
+      "nop \n\t"
+      "subi %[count], 1 \n\t"
+      "brne loop%= \n\t"
+    : [count] "+d" (nloops)
+  );
+}
+
+/**
+ * Resets the buses of the given pins at the same time, and checks which of
+ * them have slaves that respond.
+ * The port updates of wire1SyncHold/wire1SyncRelease take about 4 cycles each
+ * with a mask that is not known at compile time. The times after each step
+ * are written as comments, counted from when the wire is driven or released.
+ * @param  mask  The pins of the buses, within W1_SYNC_PIN_MASK
+ * @return       The pins of the buses where a slave responded
+ */
+uint8_t wire1SyncReset(uint8_t const mask) {
+  wire1SyncHold(mask);
+  wire1SyncDelay(122); // 496 us = 4*122 + 8
+  wire1SyncRelease(mask); // 500 us
+  // Sample all buses where the slaves hold the presence pulse (15-60 us after
+  // the release, for at least 60 us)
+  wire1SyncDelay(15); // 72 us = 4 + 4*15 + 8
+  uint8_t present = ~CONCAT_EXPAND(PIN, W1_PORT_LETTER) & mask;
+  wire1SyncDelay(105); // 502 us = 73 + 4*105 + 8
+  if (mask & BV(W1_PIN_POS))
+    wire1state = IDLE;
+  return present;
+}
+
+/**
+ * Writes a byte to the buses of the given pins at the same time, LSB first.
+ * The times of each slot are counted from when the wire is driven low.
+ * @param  mask       The pins of the buses, within W1_SYNC_PIN_MASK
+ * @param  writeByte  The byte to write
+ */
+void wire1SyncWriteByte(uint8_t const mask, uint8_t writeByte) {
+  for (int i = 0; i < 8; i++) {
+    wire1SyncHold(mask);
+    if (writeByte & BV(i)) {
+      wire1SyncRelease(mask); // 4 us low
+      wire1SyncDelay(14); // 72 us = 8 + 4*14 + 8
+    } else {
+      wire1SyncDelay(14); // 64 us = 4*14 + 8
+      wire1SyncRelease(mask); // 68 us
+    }
+  }
+}
+
+/**
+ * Reads a byte from the buses of the given pins, LSB first. Typically one bus
+ * at a time; with several buses a bit is only read as 1 if it is 1 on all.
+ * The times of each slot are counted from when the wire is driven low.
+ * @param  mask  The pins of the buses, within W1_SYNC_PIN_MASK
+ * @return       The value that was read
+ */
+uint8_t wire1SyncReadByte(uint8_t const mask) {
+  uint8_t readByte = 0;
+  for (int i = 0; i < 8; i++) {
+    wire1SyncHold(mask);
+    wire1SyncRelease(mask); // 4 us low, pull-up back at 8 us
+    // Let the wire rise, and sample well before the 15 us when the slaves may
+    // release it
+    asm volatile("rjmp .+0 \n\t" : : ); // 10 us
+    if ((CONCAT_EXPAND(PIN, W1_PORT_LETTER) & mask) == mask) { // 11 us
+      readByte |= BV(i);
+    }
+    wire1SyncDelay(13); // 75 us = 15 + 4*13 + 8
+  }
+  return readByte;
+}
+
+/**
+ * Reads the scratchpad of a device on one of the buses in W1_SYNC_PIN_MASK
+ * straight into a scatter list, e.g. to drain the readings of all buses one
+ * by one after wire1SyncConvertT. See wire1ReadScratchPad for the list.
+ * @param  mask   The pin of the bus, within W1_SYNC_PIN_MASK
+ * @param  addr   Pointer to the ROM address of the device; NULL to skip ROM
+ *                when it is the only device on the bus
+ * @param  iov    The list of destinations to read into
+ * @param  count  Number of entries in the list
+ * @return        0 - OK; 1 - calculated CRC mismatch; -1 - no device present
+ */
+int8_t wire1SyncReadScratchPad(
+  uint8_t const mask,
+  const uint8_t *const addr,
+  const wire1iovec_t *const iov,
+  uint8_t const count
+) {
+  if (!wire1SyncReset(mask))
+    return -1;
+  wire1WriteAddressWith(wire1SyncWriteByte, mask, addr);
+  wire1SyncWriteByte(mask, W1_FUNC_READ_SCRATCHPAD);
+  return wire1ReadScatterWith(wire1SyncReadByte, mask, iov, count) ? 1 : 0;
+}
+
+/**
+ * Starts a temperature conversion on all devices of all the buses in
+ * W1_SYNC_PIN_MASK at once. The reset, Skip ROM and Convert T are sent with
+ * masked port writes, so the conversions start within a few cycles of each
+ * other when this function returns. That is the time to stamp on the readings
+ * from all of the buses, which can then be read out one bus at a time with
+ * wire1SyncReadScratchPad.
+ * Slaves on the buses are not polled for when they are done.
+ *
+ * @return  The pins of the buses where a slave responded to the reset (0 if
+ *          the bus of W1_PIN_POS never went idle from a previous wait)
+ */
+uint8_t wire1SyncConvertT(void) {
+  if (wire1state == WAIT_POLL && wire1Poll4Idle() == 0) {
+    return 0;
+  }
+
+  uint8_t present = wire1SyncReset(W1_SYNC_PIN_MASK);
+  if (present) {
+    wire1SyncWriteByte(present, W1_ROMCMD_SKIP);
+    wire1SyncWriteByte(present, W1_FUNC_CONVERT_T);
+  }
+  wire1state = IDLE;
+  return present;
+}
+#endif
+
+/**
+ * Reads the scratchpad of a device into its entry in the device table, and
+ * sets W1_STATUS_SCRATCHPAD_BIT in its status if the CRC matched
+ * @param  device  The device, which shall already be addressed
+ * @return         0 - OK; 1 - calculated CRC mismatch
+ */
+static int8_t wire1ReadDevice(wire1_t *const device) {
+  uint8_t crc;
+  const wire1iovec_t iov[] = {
+    {device->scratchPad, sizeof(device->scratchPad)},
+    {&crc, 1}
+  };
+  int8_t result = wire1ReadScratchPad(iov, 2);
+  if (result == 0) {
+    device->status |= BV(W1_STATUS_SCRATCHPAD_BIT);
+  } else {
+    device->status &= ~BV(W1_STATUS_SCRATCHPAD_BIT);
+  }
+  return result;
+}
+
+/**
+ * Start-up sequence that gets the first readings out as early as possible.
+ * A conversion is started in all devices right away, and the devices are
+ * enumerated while it runs. The bus time spent is counted with the lower
+ * bounds W1_TIME_MIN_*, so that the conversion is surely done when the count
+ * says so, and from then on each device is read directly after the search
+ * pass that found it (while it is still selected). The devices found earlier
+ * are read when enumeration is done.
+ * Only for externally powered devices, since there is no strong pull-up
+ * during the conversion.
+ * A device whose scratchpad could not be read (no response to Match ROM or a
+ * CRC mismatch) is still in the table, but without W1_STATUS_SCRATCHPAD_BIT
+ * set in its status.
+ *
+ * @param  devices   The device table to fill in, in search order
+ * @param  maxCount  Size of the device table
+ * @return           Number of devices found; -1 if no device present
+ */
+int16_t wire1BootSweep(wire1_t *const devices, uint8_t const maxCount) {
+  if (wire1SkipROM())
+    return -1;
+  wire1ConvertT(0);
+
+  uint32_t elapsed = 0;
+  uint8_t count = 0;
+  uint8_t deferred = 0;
+  uint8_t lastConfPos = 0xFF;
+  uint8_t addr[8] = {0};
+  while (count < maxCount) {
+    int8_t result = wire1SearchLargerROM(addr, addr, lastConfPos);
+    if (result < 0)
+      break;
+    wire1_t *device = &devices[count++];
+    for (int i = 0; i < 8; i++) {
+      device->address[i] = addr[i];
+    }
+    device->status &= ~BV(W1_STATUS_SCRATCHPAD_BIT);
+
+    // A reset, the search command and three slots per ROM bit
+    elapsed += W1_TIME_MIN_RESET_US + (8 + 64 * 3) * W1_TIME_MIN_SLOT_US;
+    if (elapsed >= W1_TIME_CONVERT_US) {
+      wire1ReadDevice(device);
+      // Read Scratchpad and the nine bytes of the scratchpad
+      elapsed += (1 + 9) * 8 * W1_TIME_MIN_SLOT_US;
+    } else {
+      deferred = count;
+    }
+
+    if (result == 64)
+      break;
+    lastConfPos = result;
+  }
+
+  // Wait out the conversion with read slots. The last found device is still
+  // selected, so reset first. The slots are then an invalid ROM command, after
+  // which the slaves ignore the wire until the next reset.
+  if (deferred && elapsed < W1_TIME_CONVERT_US) {
+    wire1Reset();
+    elapsed += W1_TIME_MIN_RESET_US;
+  }
+  while (deferred && elapsed < W1_TIME_CONVERT_US) {
+    wire1ReadBit();
+    elapsed += W1_TIME_MIN_SLOT_US;
+  }
+  for (int i = 0; i < deferred; i++) {
+    if (!wire1MatchROM(devices[i].address)) {
+      wire1ReadDevice(&devices[i]);
+    }
+  }
+  return count;
+}
+
+/**
+ * Addresses the streamed device, see wire1StreamStart
+ * @param  addr  Pointer to the ROM address of the device; NULL to skip ROM
+ * @return       0 - OK; -1 - no device present; -3 - the wire never went idle
+ */
+static int8_t wire1StreamAddress(uint8_t *const addr) {
+  int8_t result = addr ? wire1MatchROM(addr) : wire1SkipROM();
+  if (result && wire1state == WAIT_POLL)
+    return -3;
+  return result;
+}
+
+/**
+ * Starts streaming the temperature of a single externally powered device. A
+ * conversion is started, and the wire is set up to be polled until the
+ * conversion is done on the next access. Set the resolution of the device
+ * beforehand (e.g. 9 bits) to get a high rate.
+ * @param  addr    Pointer to the ROM address of the device; NULL to use Skip
+ *                 ROM instead when it is the only device on the bus
+ * @param  nloops  The number of loops to poll for the conversion to finish,
+ *                 see wire1SetupPoll4Idle
+ * @return         0 - OK; -1 - no device present; -3 - the wire never went
+ *                 idle
+ */
+int8_t wire1StreamStart(uint8_t *const addr, uint16_t nloops) {
+  int8_t result = wire1StreamAddress(addr);
+  if (result)
+    return result;
+  wire1ConvertT(0);
+  wire1SetupPoll4Idle(nloops);
+  return 0;
+}
+
+/**
+ * Reads the temperature of the streamed device and immediately starts the
+ * next conversion. Waits for the current conversion with read slots, and only
+ * reads the two temperature bytes of the scratchpad, so there is no CRC check.
+ * @param  addr    Pointer to the ROM address given to wire1StreamStart
+ * @param  nloops  The number of loops to poll for the next conversion
+ * @param  raw     The raw temperature reading
+ * @return         0 - OK; -1 - no device present; -3 - the conversion never
+ *                 finished
+ */
+int8_t wire1StreamRead(uint8_t *const addr, uint16_t nloops, int16_t *const raw) {
+  uint8_t temperature[2];
+  const wire1iovec_t iov = {temperature, sizeof(temperature)};
+
+  int8_t result = wire1StreamAddress(addr);
+  if (result)
+    return result;
+  wire1ReadScratchPad(&iov, 1); // The reset in wire1StreamStart ends the read
+  *raw = (int16_t)(temperature[0] | (temperature[1] << 8));
+
+  return wire1StreamStart(addr, nloops);
+}
+
+/**
+ * Read the scratchpad of the addressed device straight into a scatter list.
+ * The list shall cover the whole scratchpad including the trailing CRC byte
+ * for the CRC check to pass. A shorter list ends the read early.
+ * @param  iov    The list of destinations to read into
+ * @param  count  Number of entries in the list
+ * @return        0 - OK; 1 - calculated CRC mismatch; -2 if not starting in
+ *                the correct state.
+ */
+int8_t wire1ReadScratchPad(const wire1iovec_t *const iov, uint8_t const count) {
+  if (wire1state != FUNCTION_COMMAND)
+    return -2;
+  wire1WriteByte(W1_FUNC_READ_SCRATCHPAD);
+  uint8_t crc = wire1ReadScatter(iov, count);
+  // A reset is needed to abort or finish the read
+  wire1state = IDLE;
+  return crc ? 1 : 0;
+}
+
+/**
+ * Write the scratchpad of the addressed device(s) straight from a gather list.
+ * @param  iov    The list of sources to write from
+ * @param  count  Number of entries in the list
+ * @return        0 - OK; -2 if not starting in the correct state.
+ */
+int8_t wire1WriteScratchPad(const wire1iovec_t *const iov, uint8_t const count) {
+  if (wire1state != FUNCTION_COMMAND)
+    return -2;
+  wire1WriteByte(W1_FUNC_WRITE_SCRATCHPAD);
+  wire1WriteGather(iov, count);
+  wire1state = IDLE;
+  return 0;
+}
+
+/**
+ * Checks that the CRC byte of a ROM address matches the rest of the address,
+ * e.g. before the address is used as a key for a device
+ * @param  addr  Pointer to an 8-byte array where the ROM address is stored
+ * @return       1 if the CRC matches; otherwise 0
+ */
+uint8_t wire1CheckROM(uint8_t *const addr) {
+  return addr[W1_ADDR_BYTE_CRC] == crc8(0, W1_CRC_POLYNOMIAL, addr, W1_ADDR_BYTE_CRC);
+}
+
+/**
+ * Compares two ROM addresses in the order that wire1SearchLargerROM finds them,
+ * i.e. as 64-bit numbers where bit 0 of byte 0 is the most significant bit.
+ * @param  a  Pointer to an 8-byte array with the first ROM address
+ * @param  b  Pointer to an 8-byte array with the second ROM address
+ * @return    negative if a is found before b; 0 if equal; positive if a is
+ *            found after b
+ */
+int8_t wire1CompareROM(const uint8_t *const a, const uint8_t *const b) {
+  for (int i = 0; i < 8; i++) {
+    uint8_t diff = a[i] ^ b[i];
+    if (diff) {
+      // The lowest differing bit is the one that the search branched at
+      return (a[i] & diff & -diff) ? 1 : -1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Looks up a ROM address in a device table with a binary search. The table
+ * shall be sorted in search order, which it is if it was filled in the order
+ * that wire1SearchLargerROM found the devices.
+ * @param  devices  The device table
+ * @param  count    Number of devices in the table
+ * @param  addr     Pointer to an 8-byte array with the ROM address to find
+ * @return          Index of the device in the table; -1 if not found
+ */
+int16_t wire1FindROM(
+  const wire1_t *const devices,
+  uint8_t const count,
+  const uint8_t *const addr
+) {
+  uint8_t low = 0, high = count;
+  while (low < high) {
+    uint8_t mid = low + (high - low) / 2;
+    int8_t cmp = wire1CompareROM(devices[mid].address, addr);
+    if (cmp == 0) {
+      return mid;
+    } else if (cmp < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Estimates the bus time for enumerating devices with wire1SearchLargerROM.
+ * Each device takes one search pass, which is a reset, the search command and
+ * two read slots plus one write slot per ROM bit.
+ * @param  count  Number of devices on the bus
+ * @return        The estimated time in us
+ */
+uint32_t wire1EstimateSearchUs(uint8_t const count) {
+  uint32_t pass = W1_TIME_RESET_US + 8 * W1_TIME_WRITE_SLOT_US +
+                  64 * (2 * W1_TIME_READ_SLOT_US + W1_TIME_WRITE_SLOT_US);
+  return count * pass;
+}
+
+/**
+ * Estimates the conversion time of a device from its cached scratchpad. Only
+ * the DS18B20 resolution is known, other devices and DS18B20s whose
+ * scratchpad has not been read yet get the longest time. Parasite power does
+ * not change the conversion time, only how it can be waited for.
+ * @param  device  The device
+ * @return         The estimated time in us
+ */
+uint32_t wire1EstimateConvertUs(const wire1_t *const device) {
+  if (device->address[W1_ADDR_BYTE_DEV_TYPE] != DS18B20)
+    return W1_TIME_CONVERT_US;
+  uint8_t config = device->scratchPad[W1_SCRATCHPAD_BYTE_CONFIG];
+  if ((config & W1_CONFIG_RESERVED_MASK) != W1_CONFIG_RESERVED_MASK)
+    return W1_TIME_CONVERT_US;
+  uint8_t resolution = (config & W1_CONFIG_RESOLUTION_MASK) >>
+                       W1_CONFIG_RESOLUTION_POS;
+  return W1_TIME_CONVERT_US >> (3 - resolution);
+}
+
+/**
+ * Estimates the bus time for reading the scratchpad of one device, i.e. a
+ * Match ROM followed by Read Scratchpad
+ * @param  device  The device
+ * @return         The estimated time in us
+ */
+uint32_t wire1EstimateReadUs(const wire1_t *const device) {
+  (void)device; // All devices have the same scratchpad size for now
+  return W1_TIME_RESET_US + (1 + 8 + 1) * 8 * W1_TIME_WRITE_SLOT_US +
+         9 * 8 * W1_TIME_READ_SLOT_US;
+}
+
+/**
+ * Estimates the time of a full sweep: one Skip ROM and Convert T for all
+ * devices, waiting for the slowest conversion, and then reading every device.
+ * The parasite flags of the devices do not change the estimate: with parasite
+ * power the bus is held by the strong pull-up for the whole conversion, and
+ * without it the poll for the slowest device ends at the same time.
+ * @param  devices  The device table
+ * @param  count    Number of devices in the table
+ * @return          The estimated time in us
+ */
+uint32_t wire1EstimateSweepUs(const wire1_t *const devices, uint8_t const count) {
+  uint32_t convert = 0;
+  uint32_t read = 0;
+  for (int i = 0; i < count; i++) {
+    uint32_t deviceConvert = wire1EstimateConvertUs(&devices[i]);
+    if (deviceConvert > convert)
+      convert = deviceConvert;
+    read += wire1EstimateReadUs(&devices[i]);
+  }
+  return W1_TIME_RESET_US + 2 * 8 * W1_TIME_WRITE_SLOT_US + convert + read;
+}
+
 /**
  * Calculate an 8-bit CRC for size number of byte of data. Shifts the data
  * from MSB to LSB and XOR:s the polynomial each time the LSB of the remainder
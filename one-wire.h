@@ -1,3 +1,12 @@
+#ifndef ONE_WIRE_H
+#define ONE_WIRE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #ifndef BV
 #  define BV(n) (1 << (n))
 #endif
@@ -20,7 +29,8 @@ enum wire1state_t {
 
 /** The device type */
 enum wire1device_t {
-  DS18B20 = 0x28
+  DS18B20 = 0x28,
+  DS2408  = 0x29
 };
 
 typedef struct {
@@ -29,7 +39,8 @@ typedef struct {
   /**
    * A bit field specifying the cached status of the device
    * Bits represent boolean values:
-   *   [7:1] device specific (reserved)
+   *   [7:3] device specific (reserved)
+   *   [2] Scratchpad read with a matching CRC
    *   [1] Parasite power
    *   [0] reserved
    */
@@ -37,7 +48,42 @@ typedef struct {
   uint8_t scratchPad[8];
 } wire1_t;
 
+/**
+ * One entry of a scatter/gather list, used for block transfers directly
+ * into/out of the application's own fields
+ */
+typedef struct {
+  /** Start of the bytes to transfer */
+  uint8_t *data;
+  /** Number of bytes to transfer */
+  uint8_t size;
+} wire1iovec_t;
+
+/** The state of one bus, when several buses are driven through a backend */
+typedef struct {
+  /** State of the wire, see wire1GetState */
+  enum wire1state_t state;
+  /** Number of loops to poll for the wire to go idle */
+  uint16_t idleloops;
+  /** Backend specific data for the bus, e.g. its simulated slaves */
+  void *backend;
+} wire1context_t;
+
+/** State of a search pass that is driven one ROM bit at a time */
+typedef struct {
+  uint8_t *addrOut;
+  uint8_t *addrStart;
+  uint8_t lastConfPos;
+  /** Conflict position to return, see wire1SearchLargerROM */
+  int8_t currConfPos;
+  /** The next ROM bit */
+  uint8_t bit;
+  /** The ROM byte being searched */
+  uint8_t romByte;
+} wire1search_t;
+
 // Bit positions in the status byte for each device
+#define W1_STATUS_SCRATCHPAD_BIT     2
 #define W1_STATUS_PARASITE_POWER_BIT 1
 #define W1_STATUS_ADDRESS_BIT        0
 
@@ -48,6 +94,26 @@ typedef struct {
 #define W1_ADDR_BYTE_CRC        7
 #define W1_ADDR_BYTE_DEV_TYPE   0
 
+// Significant byte positions in the DS18B20 scratchpad
+#define W1_SCRATCHPAD_BYTE_CONFIG    4
+// Resolution bits in the configuration byte (0 - 9 bit ... 3 - 12 bit)
+#define W1_CONFIG_RESOLUTION_POS     5
+#define W1_CONFIG_RESOLUTION_MASK    (3 << W1_CONFIG_RESOLUTION_POS)
+// The low bits of the configuration byte always read as 1
+#define W1_CONFIG_RESERVED_MASK      0x1F
+
+// Approximate bus time of the operations in us, including the call overhead.
+// The slots are cycle counted for an AVR running at 1 MHz.
+#define W1_TIME_RESET_US             900
+#define W1_TIME_READ_SLOT_US         95
+#define W1_TIME_WRITE_SLOT_US        85
+// Conversion time at 12-bit resolution (halved for each bit less)
+#define W1_TIME_CONVERT_US           750000UL
+// Lower bounds of the reset and slot times, for counting time that must have
+// passed on any backend: the shortest reset pulse and slot that slaves accept
+#define W1_TIME_MIN_RESET_US         480
+#define W1_TIME_MIN_SLOT_US          60
+
 // ROM commands
 #define W1_ROMCMD_READ             0x33
 #define W1_ROMCMD_MATCH            0x55
@@ -56,23 +122,50 @@ typedef struct {
 #define W1_ROMCMD_SKIP             0xCC
 
 // Function commands
+#define W1_FUNC_CONVERT_T            0x44
+#define W1_FUNC_WRITE_SCRATCHPAD     0x4E
+#define W1_FUNC_READ_SCRATCHPAD      0xBE
+#define W1_FUNC_COPY_SCRATCHPAD      0x48
+#define W1_FUNC_RECALL_EEPROM        0xB8
 #define W1_FUNC_PARASITE_POWER       0xB4
 
+// Bus backend. The AVR implementation in one-wire.c is used unless
+// W1_BACKEND_EXTERN is defined, in which case wire1ResetPulse, wire1ReadBit
+// and wire1WriteBit shall be provided by another backend (e.g. a simulated
+// bus in a host tool) and the rest of the library runs unmodified on top.
+// Each bus then has a context of its own, and the protocol functions work on
+// the selected one. Define W1_BACKEND_THREADS as well to keep the selection
+// per thread, when buses are run from several threads.
+// A backend that can run several slots in one go (e.g. with a timer and DMA)
+// may also define W1_BACKEND_BYTES and provide wire1ReadByte/wire1WriteByte.
+#ifdef W1_BACKEND_EXTERN
+void            wire1SetContext(wire1context_t *const context);
+wire1context_t *wire1GetContext(void);
+#endif
+
 // "Macro" functions
 void    wire1Hold(void);
 void    wire1Release(void);
+void    wire1StrongPullUp(void);
 uint8_t wire1Poll4Hold(uint8_t us);
 uint8_t wire1Poll4Release(uint8_t us);
 
 // Initialization of devices
 int8_t  wire1Reset(void);
+int8_t  wire1ResetPulse(void);
 void    wire1SetupPoll4Idle(uint16_t nloops);
+uint16_t wire1SleepPoll4Idle(uint8_t strongPullUp);
 
 // Reading/writing bits/bytes
 uint8_t wire1ReadBit(void);
 void    wire1WriteBit(uint8_t bit);
 uint8_t wire1ReadByte(void);
 void    wire1WriteByte(uint8_t writeByte);
+void    wire1WriteBytePullUp(uint8_t writeByte);
+
+// Scatter/gather block transfers
+uint8_t wire1ReadScatter(const wire1iovec_t *const iov, uint8_t const count);
+void    wire1WriteGather(const wire1iovec_t *const iov, uint8_t const count);
 
 // Searching devices
 int8_t  wire1SearchLargerROM(
@@ -86,12 +179,61 @@ int8_t  wire1AlarmSearchLargerROM(
   const uint8_t lastConfPos
 );
 
+void    wire1SearchBegin(
+  wire1search_t *const search,
+  uint8_t *const addrOut,
+  uint8_t *const addrStart,
+  uint8_t const lastConfPos
+);
+int8_t  wire1SearchStep(
+  wire1search_t *const search,
+  uint8_t const addrAck,
+  uint8_t const addrNAck
+);
+int8_t  wire1SearchEnd(wire1search_t *const search);
+
 // Addressing devices
 int8_t wire1ReadSingleROM(uint8_t *const addr);
 int8_t wire1MatchROM(uint8_t *const addr);
 int8_t wire1SkipROM();
 
+// Looking up devices
+int8_t  wire1CompareROM(const uint8_t *const a, const uint8_t *const b);
+int16_t wire1FindROM(
+  const wire1_t *const devices,
+  uint8_t const count,
+  const uint8_t *const addr
+);
+
 int8_t wire1ReadPowerSupply(void);
+int8_t wire1ConvertT(uint8_t strongPullUp);
+int8_t wire1ReadScratchPad(const wire1iovec_t *const iov, uint8_t const count);
+int8_t wire1WriteScratchPad(const wire1iovec_t *const iov, uint8_t const count);
+
+// Start-up
+int16_t wire1BootSweep(wire1_t *const devices, uint8_t const maxCount);
+
+// Streaming a single device
+int8_t wire1StreamStart(uint8_t *const addr, uint16_t nloops);
+int8_t wire1StreamRead(uint8_t *const addr, uint16_t nloops, int16_t *const raw);
+
+// Synchronised conversions on several buses
+uint8_t wire1SyncConvertT(void);
+uint8_t wire1SyncReset(uint8_t const mask);
+void    wire1SyncWriteByte(uint8_t const mask, uint8_t writeByte);
+uint8_t wire1SyncReadByte(uint8_t const mask);
+int8_t  wire1SyncReadScratchPad(
+  uint8_t const mask,
+  const uint8_t *const addr,
+  const wire1iovec_t *const iov,
+  uint8_t const count
+);
+
+// Estimating bus time
+uint32_t wire1EstimateSearchUs(uint8_t const count);
+uint32_t wire1EstimateConvertUs(const wire1_t *const device);
+uint32_t wire1EstimateReadUs(const wire1_t *const device);
+uint32_t wire1EstimateSweepUs(const wire1_t *const devices, uint8_t const count);
 
 // General functions
 uint8_t crc8(
@@ -100,4 +242,11 @@ uint8_t crc8(
   uint8_t *const array,
   uint8_t const size
 );
+uint8_t wire1CheckROM(uint8_t *const addr);
 enum wire1state_t wire1GetState(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef ONE_WIRE_HPP
+#define ONE_WIRE_HPP
+
+#include "one-wire.h"
+
+// Typestate transaction API. A transaction is written as one chained
+// expression, e.g.
+//   wire1::reset().match(addr).convertT();
+// reset gives a RomPhase, the ROM commands turn it into a FunctionPhase, and
+// the function commands consume that. The phases can only be created by the
+// step before them and their commands only be called on temporaries, so in
+// the chained form an out of order or repeated command does not compile, and
+// the wire1state checks are not used. The guarantee only holds for the chained
+// form: a phase that is stored in a variable can still be cast to a temporary
+// (e.g. with std::move) and used more than once. Whether a slave responded to
+// the reset is carried along and checked at runtime by every command, which
+// does nothing if none did.
+namespace wire1 {
+
+class FunctionPhase;
+class RomPhase;
+inline RomPhase reset();
+
+/** The slaves have been reset and wait for a ROM command */
+class RomPhase {
+ public:
+  RomPhase(RomPhase &&) = default;
+  RomPhase(const RomPhase &) = delete;
+  RomPhase &operator=(const RomPhase &) = delete;
+
+  /** @return  Whether any slave responded to the reset */
+  bool present() const { return present_; }
+
+  inline FunctionPhase match(const uint8_t *const addr) &&;
+  inline FunctionPhase skip() &&;
+
+ private:
+  friend RomPhase reset();
+  explicit RomPhase(bool present) : present_(present) {}
+  bool present_;
+};
+
+/** A device (or all devices) has been addressed and waits for a function */
+class FunctionPhase {
+ public:
+  FunctionPhase(FunctionPhase &&) = default;
+  FunctionPhase(const FunctionPhase &) = delete;
+  FunctionPhase &operator=(const FunctionPhase &) = delete;
+
+  /** @return  Whether the addressed device(s) may be present */
+  bool present() const { return present_; }
+
+  /** Starts a temperature conversion in the addressed device(s) */
+  void convertT() && {
+    if (present_)
+      wire1WriteByte(W1_FUNC_CONVERT_T);
+  }
+
+  /**
+   * Reads the scratchpad straight into a scatter list, see wire1ReadScratchPad
+   * @return  Whether the CRC matched
+   */
+  bool readScratchPad(const wire1iovec_t *const iov, uint8_t const count) && {
+    if (!present_)
+      return false;
+    wire1WriteByte(W1_FUNC_READ_SCRATCHPAD);
+    return wire1ReadScatter(iov, count) == 0;
+  }
+
+  /** Writes the scratchpad straight from a gather list */
+  void writeScratchPad(const wire1iovec_t *const iov, uint8_t const count) && {
+    if (!present_)
+      return;
+    wire1WriteByte(W1_FUNC_WRITE_SCRATCHPAD);
+    wire1WriteGather(iov, count);
+  }
+
+  /** @return  Whether any of the addressed slaves use parasite power */
+  bool readPowerSupply() && {
+    if (!present_)
+      return false;
+    wire1WriteByte(W1_FUNC_PARASITE_POWER);
+    return !wire1ReadBit();
+  }
+
+ private:
+  friend class RomPhase;
+  explicit FunctionPhase(bool present) : present_(present) {}
+  bool present_;
+};
+
+/**
+ * Resets all 1-wire devices and starts a transaction. Goes through wire1Reset,
+ * so that a pending wire1SetupPoll4Idle is waited out first, and wire1state
+ * is left at ROM_COMMAND (or IDLE). The commands of the phases do not update
+ * it, so a C function command called after a transaction fails its state
+ * check instead of running on a bus that is no longer addressed.
+ * @return  The phase for issuing a ROM command (not present if the wire never
+ *          went idle)
+ */
+inline RomPhase reset() {
+  return RomPhase(wire1Reset() == 1);
+}
+
+/**
+ * Sends the ROM address of the device to access
+ * @param addr  Pointer to an 8-byte array where the ROM address is stored
+ */
+FunctionPhase RomPhase::match(const uint8_t *const addr) && {
+  if (present_) {
+    wire1WriteByte(W1_ROMCMD_MATCH);
+    for (int i = 0; i < 8; i++) {
+      wire1WriteByte(addr[i]);
+    }
+  }
+  return FunctionPhase(present_);
+}
+
+/** Skips ROM addressing so that all devices are accessed simultaneously */
+FunctionPhase RomPhase::skip() && {
+  if (present_)
+    wire1WriteByte(W1_ROMCMD_SKIP);
+  return FunctionPhase(present_);
+}
+
+}
+
+#endif